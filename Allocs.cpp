@@ -0,0 +1,211 @@
+//----------------------------------------------------------------------------//
+//
+// Implementation file for the Allocs namespace of the cribtutor program.
+//
+// The Allocs namespace counts the allocations made by each subsystem.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include "Allocs.h"
+#include "Lock.h"
+
+#include <iomanip>
+#include <new>
+
+#include <cstdlib>
+
+using namespace std;
+
+//----------------------------------------------------------------------------//
+//
+// See Allocs.h for a description of the interface.
+//
+// The replacements of operator new and operator delete are those of the
+// standard library with counting added.  They count into the Totals of the
+// thread, which are allocated by calloc(), not by operator new, when the
+// thread first counts and linked into the list of all Totals, the only time
+// the mutex is taken.  Like Stats (see Stats.cpp), Totals are never released.
+//
+// The replacements are the same whichever the standard but their exception
+// specifications are not.  Since C++14 there are also sized forms of operator
+// delete, which just forward to the unsized ones.
+//
+//----------------------------------------------------------------------------//
+
+# if __cplusplus >= 201103L
+#   define  THROWS_BAD_ALLOC
+#   define  THROWS_NOTHING      noexcept
+# else
+#   define  THROWS_BAD_ALLOC    throw (std::bad_alloc)
+#   define  THROWS_NOTHING      throw ()
+# endif
+
+namespace       Allocs
+{
+    struct  Totals
+    {
+        unsigned long long  allocs[tags];
+        unsigned long long  bytes[tags];
+        unsigned long long  frees[tags];
+
+        Totals*     next;                   // those of another thread
+    };
+
+    static  Totals&     attach (void);
+
+    static  __thread    Totals*     totals = 0;
+
+    static  Totals*     all = 0;            // the Totals of every thread that has counted
+
+    static  pthread_mutex_t     mutex = PTHREAD_MUTEX_INITIALIZER;
+};
+
+__thread Allocs::Tag    Allocs::current = Allocs::other;
+
+bool    Allocs::enabled = false;
+
+//----  allocate memory and count it
+
+void*   operator new (size_t size) THROWS_BAD_ALLOC
+{
+    if (size == 0)
+        size = 1;
+
+    void*   memory;
+
+    while ((memory = malloc(size)) == 0)
+    {
+        new_handler     handler = set_new_handler(0);
+
+        set_new_handler(handler);
+
+        if (!handler)
+            throw bad_alloc ();
+
+        handler();
+    }
+
+    if (Allocs::enabled)
+    {
+        Allocs::Totals&     totals = Allocs::totals ? *Allocs::totals : Allocs::attach();
+
+        totals.allocs[Allocs::current] += 1;
+        totals.bytes[Allocs::current] += size;
+    }
+
+    return (memory);
+}
+
+void*   operator new[] (size_t size) THROWS_BAD_ALLOC
+{
+    return (operator new (size));
+}
+
+//----  free memory and count it
+
+void    operator delete (void* memory) THROWS_NOTHING
+{
+    if (!memory)
+        return;
+
+    if (Allocs::enabled)
+        (Allocs::totals ? *Allocs::totals : Allocs::attach()).frees[Allocs::current] += 1;
+
+    free(memory);
+}
+
+void    operator delete[] (void* memory) THROWS_NOTHING
+{
+    operator delete (memory);
+}
+
+# if __cplusplus >= 201402L
+
+void    operator delete (void* memory, size_t) THROWS_NOTHING
+{
+    operator delete (memory);
+}
+
+void    operator delete[] (void* memory, size_t) THROWS_NOTHING
+{
+    operator delete (memory);
+}
+
+# endif
+
+//----  allocate the Totals of this thread
+
+Allocs::Totals&     Allocs::attach (void)
+{
+    totals = (Totals *) calloc(1, sizeof(Totals));
+
+    if (!totals)
+        abort();
+
+    Lock    lock (mutex);
+
+    totals->next = all;
+
+    all = totals;
+
+    return (*totals);
+}
+
+//----  print the totals of all threads
+
+void    Allocs::report (ostream& stream)
+{
+    Totals  sum = Totals ();
+
+    {
+        Lock    lock (mutex);
+
+        for (const Totals* it = all; it; it = it->next)
+        {
+            for (int ii = 0; ii < tags; ++ii)
+            {
+                sum.allocs[ii] += it->allocs[ii];
+                sum.bytes[ii] += it->bytes[ii];
+                sum.frees[ii] += it->frees[ii];
+            }
+        }
+    }
+
+    static  const char* const   names[tags] = { "other", "parse", "  massage", "  annotate", "render", "  mask", "  check", "  dialogue" };
+
+    unsigned long long  allocs = 0;
+    unsigned long long  bytes = 0;
+    unsigned long long  frees = 0;
+
+    for (int ii = 0; ii < tags; ++ii)
+    {
+        allocs += sum.allocs[ii];
+        bytes += sum.bytes[ii];
+        frees += sum.frees[ii];
+    }
+
+    const ios_base::fmtflags    flags = stream.flags();
+
+    stream << "Allocations:" << endl;
+    stream << "    subsystem       allocs        bytes        frees" << endl;
+
+    for (int ii = 0; ii < tags; ++ii)
+    {
+        stream << "    " << left << setw(11) << names[ii] << right;
+        stream << setw(11) << sum.allocs[ii] << setw(13) << sum.bytes[ii] << setw(13) << sum.frees[ii] << endl;
+    }
+
+    stream << "    total      " << setw(11) << allocs << setw(13) << bytes << setw(13) << frees << endl;
+
+    stream.flags(flags);
+}
+
+// EOF
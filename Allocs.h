@@ -0,0 +1,92 @@
+# ifndef    _ALLOCS_H
+# define    _ALLOCS_H
+
+//----------------------------------------------------------------------------//
+//
+// Interface file for the Allocs namespace of the cribtutor program.
+//
+// Much of the time the program takes goes on allocating and freeing the
+// memory behind strings and containers.  The Allocs namespace replaces the
+// global operator new and operator delete to count the allocations made and
+// the bytes allocated by each subsystem of the program.  With the --allocs
+// flag, the counts are reported on stderr when the program exits.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include <iostream>
+
+using namespace std;
+
+//----------------------------------------------------------------------------//
+//
+// Allocations are attributed to the subsystem named by the innermost Scope,
+// a guard that names the subsystem of the thread until the end of its scope:
+//
+//      {
+//          Allocs::Scope   scope (Allocs::parse);
+//          ...
+//      }
+//
+// The subsystems are:
+//    - other - all that is not in the scope of another subsystem
+//    - parse - the html and Markdown parsers (see Html.h and Markdown.h)
+//    - massage - the placing of sub elements, within parse
+//    - annotate - the annotation of the parts of elements, within parse
+//    - render - running the quiz on a cribsheet or printing it
+//    - mask and check - Terms::mask() and Terms::check(), within render
+//    - dialogue - the dialogue with the user, within render
+//
+// Frees are attributed to the subsystem of the Scope that frees the memory,
+// not to the one that allocated it:  a string built by parse and freed by
+// render is an allocation of parse but a free of render.  So the allocs and
+// frees of a subsystem do not balance:  only their totals may be compared.
+//
+// Scopes are entered whether or not Allocs::enabled is set:  a Scope costs
+// two stores of a thread local variable.  Allocations are counted only when
+// it is set.
+//
+// Elements are allocated from arenas (see Arena.h), not by operator new, and
+// so are not counted.  Nor are the blocks of the arenas.
+//
+// The counts are kept in Totals of each thread's own, without locks, and
+// added up by Allocs::report().
+//
+//----------------------------------------------------------------------------//
+
+namespace       Allocs
+{
+    enum    Tag
+    {
+        other, parse, massage, annotate, render, mask, check, dialogue, tags
+    };
+
+    extern  __thread    Tag     current;    // of this thread
+
+    class   Scope
+    {
+    public:
+        explicit Scope (const Tag tag) : outer (current)    { current = tag; }
+       ~Scope ()                                            { current = outer; }
+
+    private:
+        Scope (const Scope&);               // not implemented
+        Scope& operator= (const Scope&);    // not implemented
+
+    private:
+        Tag     outer;
+    };
+
+    extern  bool    enabled;
+
+    extern  void    report (ostream& stream);
+};
+
+# endif  /* _ALLOCS_H */
@@ -0,0 +1,167 @@
+//----------------------------------------------------------------------------//
+//
+// Implementation file for the Html::Arena class of the cribtutor program.
+//
+// The Arena class is a bump allocator for the Element objects of a parse
+// tree.  See Arena.h for a description of the class interface.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include "Arena.h"
+#include "Html.h"
+#include "Lock.h"
+#include "Stats.h"
+
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+//----------------------------------------------------------------------------//
+//
+// An arena is a singly linked list of blocks.  Allocation takes the next free
+// bytes from the head block and starts a new block when the head block is
+// full.  A request too large for a normal block gets a block of its own.
+//
+// Allocations are rounded up to a multiple of 8 bytes, the alignment of the
+// pointers in an Element.  The block header is a multiple of 8 bytes too.
+//
+// Each block holds a run of elements, one every roundUp(sizeof(Element))
+// bytes, so the arena destroys its elements by stepping through its blocks.
+//
+//----------------------------------------------------------------------------//
+
+struct  Html::Arena::Block
+{
+    Block*  next;
+    size_t  used;
+    size_t  size;
+};
+
+namespace
+{
+    const size_t    blockSize = 64 * 1024;
+    const size_t    alignment = 8;
+
+    inline  size_t  roundUp (size_t size)
+    {
+        return ((size + alignment - 1) / alignment * alignment);
+    }
+
+    pthread_mutex_t     fallbackMutex = PTHREAD_MUTEX_INITIALIZER;
+};
+
+__thread Html::Arena*   Html::Arena::current = 0;
+
+//----  create an arena
+
+Html::Arena::Arena () :
+    head (0),
+    allocationCount (0),
+    blockCount (0)
+{
+}
+
+//----  destroy the elements and release all blocks
+
+Html::Arena::~Arena ()
+{
+    const size_t    step = roundUp(sizeof(Element));
+
+    while (head)
+    {
+        Block*  next = head->next;
+
+        char*   memory = (char *) (head + 1);
+
+        for (size_t used = 0; used < head->used; used += step)
+            ((Element *) (memory + used))->~Element();
+
+        free(head);
+
+        head = next;
+    }
+}
+
+//----  allocate from the current arena - the fallback arena is shared by all threads
+
+void*   Html::Arena::allocate (size_t size)
+{
+    if (current)
+        return (current->bump(size));
+
+    Lock    lock (fallbackMutex);
+
+    return (fallback().bump(size));
+}
+
+//----  allocate from this arena
+
+void*   Html::Arena::bump (size_t size)
+{
+    size = roundUp(size);
+
+    if (head == 0 || head->used + size > head->size)
+    {
+        const size_t    payload = (size > blockSize) ? size : blockSize;
+
+        Block*  block = (Block *) malloc(sizeof(Block) + payload);
+
+        if (block == 0)
+            throw bad_alloc();
+
+        block->next = head;
+        block->used = 0;
+        block->size = payload;
+
+        head = block;
+
+        ++blockCount;
+    }
+
+    void*   memory = (char *) (head + 1) + head->used;
+
+    head->used += size;
+
+    ++allocationCount;
+
+    return (memory);
+}
+
+//----  the arena used when there is no current arena - never released
+
+Html::Arena&    Html::Arena::fallback (void)
+{
+    static  Arena*  arena = new Arena;
+
+    return (*arena);
+}
+
+//----------------------------------------------------------------------------//
+//
+// Element objects are allocated from the current arena.  They are destroyed
+// and their memory returned only when the arena is destroyed so operator delete
+// (called only if a constructor throws) does nothing.
+//
+//----------------------------------------------------------------------------//
+
+void*   Html::Element::operator new (size_t size)
+{
+    Stats::count(Stats::elements);
+
+    return (Arena::allocate(size));
+}
+
+void    Html::Element::operator delete (void*)
+{
+}
+
+// EOF
@@ -0,0 +1,116 @@
+# ifndef    _ARENA_H
+# define    _ARENA_H
+
+//----------------------------------------------------------------------------//
+//
+// Interface file for the Html::Arena class of the cribtutor program.
+//
+// The parse tree of a cribsheet is built from many small Element objects.
+// Allocating each one separately from the heap, and freeing each one
+// separately afterwards, is a significant part of the cost of parsing.
+//
+// The Arena class is a bump allocator for Element objects.  Elements are
+// carved out of a few large blocks and the blocks are released together when
+// the arena is destroyed.
+//
+// The arena also owns the elements:  it destroys them all, one after another,
+// when it is destroyed.  The parse tree is never walked to destroy it.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include <cstddef>
+
+using namespace std;
+
+//----------------------------------------------------------------------------//
+//
+// An Arena is made current by an Arena::Scope, a scope guard.  While the
+// scope exists every Element created with new is allocated from the arena:
+//
+//      {
+//          Html::Arena         arena;
+//          Html::Arena::Scope  scope (arena);
+//          Html::Element       html;
+//
+//          Html::parseCribSheet(text, length, html);
+//          ...
+//      }
+//
+// The top level element (html above) is not in the arena but refers to
+// elements that are so it must be destroyed before the arena.  Declaring the
+// arena first, as above, ensures this.
+//
+// Elements are not deleted.  Every object allocated from an arena must be an
+// Element since the arena runs the Element destructor on each.
+//
+// Each thread has its own current arena so that several threads may build
+// parse trees at once, each in its own arena.  An arena may be made current
+// by one thread, to build a tree, and later by another, to use it, but an
+// arena must not be current in two threads at once.
+//
+// Elements created when there is no current arena come from a fallback arena
+// that lasts as long as the program and is shared by all threads.
+//
+// Scopes nest:  destroying a scope makes the previous arena current again.
+//
+//----------------------------------------------------------------------------//
+
+namespace       Html
+{
+    class   Arena
+    {
+    public:
+        Arena ();
+       ~Arena ();
+
+    public:
+        class   Scope
+        {
+        public:
+            explicit Scope (Arena& arena) : previous (current)  { current = &arena; }
+           ~Scope ()                                            { current = previous; }
+
+        private:
+            Scope (const Scope&);               // not implemented
+            Scope& operator= (const Scope&);    // not implemented
+
+        private:
+            Arena*  previous;
+        };
+
+    public:
+        static  void*   allocate (size_t size);
+
+        size_t  allocations (void) const    { return (allocationCount); }
+        size_t  blocks (void) const         { return (blockCount); }
+
+    private:
+        struct  Block;
+
+        void*   bump (size_t size);
+
+        static  Arena&  fallback (void);
+
+    private:
+        Arena (const Arena&);               // not implemented
+        Arena& operator= (const Arena&);    // not implemented
+
+    private:
+        Block*  head;
+
+        size_t  allocationCount;
+        size_t  blockCount;
+
+        static  __thread    Arena*  current;
+    };
+};
+
+# endif  /* _ARENA_H */
@@ -0,0 +1,488 @@
+//----------------------------------------------------------------------------//
+//
+// Implementation file for the Cache namespace of the cribtutor program.
+//
+// The Cache namespace saves the final parse tree of a cribsheet to a file and
+// loads it from there the next time, provided the cribsheet is unchanged.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include "Cache.h"
+#include "Html.h"
+#include "MappedFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+//----------------------------------------------------------------------------//
+//
+// See Cache.h for a description of the interface.
+//
+// A cache file is a header followed by the parse tree.
+//
+// The header holds the magic number, the format version, the size,
+// modification time and hash of the cribsheet, and the names of the tags
+// above Markup::known that appear in the tree.  Tag values above known are
+// given out by each run of the program in the order tags are met so the cache
+// records their names and they are interned again when the cache is loaded.
+//
+// The tree is written depth first, each element followed by its parts and
+// each part by its subelement.  Lengths and counts precede what they count.
+// The tree is walked with an explicit stack so that its depth is not limited
+// by the call stack.
+//
+// Integers are written in the byte order of the machine.  A cache file
+// written on a machine of the other byte order fails the version check.
+//
+// The cache file is mapped and the tree rebuilt in one pass over the mapping.
+// Processes that load the same cache file share its pages.  Every read is
+// bounds checked so that a truncated or corrupt cache file is merely out of
+// date.
+//
+// A cache file is written to a temporary file that is then renamed so that
+// another process never sees a partly written cache file.
+//
+// The format version must change whenever the parse tree, or what parsing,
+// massaging or annotating makes of a cribsheet, changes.
+//
+//----------------------------------------------------------------------------//
+
+namespace       Cache
+{
+    // cache file path names and validation
+
+    static  string  cacheDirectory (const string& pathName);
+    static  string  cacheFile (const string& pathName);
+
+    static  unsigned long long  hash (const char* text, size_t length);
+
+    // the serialised form of the parse tree
+
+    class   Writer;
+    class   Reader;
+
+    static  const size_t    partSize = 5;   // the least a part takes:  flags and text length
+
+    static  void    writeElement (Writer& output, const Html::Element& element, map< Html::Tag, Html::Tag >& tags);
+    static  bool    readElement (Reader& input, Html::Element& element, const vector< Html::Tag >& tags);
+
+    static  void    writeHeader (Writer& output, const Html::Element& element, map< Html::Tag, Html::Tag >& tags);
+    static  bool    readHeader (Reader& input, Html::Element& element, const vector< Html::Tag >& tags, unsigned& partCount);
+
+    // identifies a cache file
+
+    static  const char      magic[8] = { 'c', 'r', 'i', 'b', 't', 'u', 't', 'r' };
+    static  const unsigned  version = 3;
+};
+
+//----------------------------------------------------------------------------//
+//
+// Writer appends integers and strings to a buffer.  Reader reads them back
+// from a mapping, failing rather than reading beyond its end.
+//
+//----------------------------------------------------------------------------//
+
+class   Cache::Writer
+{
+public:
+    void    put (const void* data, size_t length)   { buffer.append((const char *) data, length); }
+
+    void    put8 (unsigned char value)              { put(&value, sizeof(value)); }
+    void    put32 (unsigned value)                  { put(&value, sizeof(value)); }
+    void    put64 (unsigned long long value)        { put(&value, sizeof(value)); }
+
+    void    putString (const string& value)         { put32(value.length()); put(value.data(), value.length()); }
+
+    const string&   contents (void) const           { return (buffer); }
+
+private:
+    string  buffer;
+};
+
+class   Cache::Reader
+{
+public:
+    Reader (const char* data, size_t length) :
+        cursor (data),
+        end (data + length)
+        {}
+
+    bool    get (void* data, size_t length)
+    {
+        if ((size_t) (end - cursor) < length)
+            return (false);
+
+        memcpy(data, cursor, length);
+        cursor += length;
+
+        return (true);
+    }
+
+    bool    get8 (unsigned char& value)             { return (get(&value, sizeof(value))); }
+    bool    get32 (unsigned& value)                 { return (get(&value, sizeof(value))); }
+    bool    get64 (unsigned long long& value)       { return (get(&value, sizeof(value))); }
+
+    bool    getString (string& value)
+    {
+        unsigned    length;
+
+        if (!get32(length) || (size_t) (end - cursor) < length)
+            return (false);
+
+        value.assign(cursor, length);
+        cursor += length;
+
+        return (true);
+    }
+
+    bool    atEnd (void) const                      { return (cursor == end); }
+    size_t  remaining (void) const                  { return (end - cursor); }
+
+private:
+    const char*     cursor;
+    const char*     end;
+};
+
+//----------------------------------------------------------------------------//
+//
+// The interface routines.
+//
+//----------------------------------------------------------------------------//
+
+//----  load the parse tree from the cache file if it is up to date
+
+bool    Cache::load (const string& pathName, const char* text, size_t length, Html::Element& html)
+{
+    struct stat     status;
+
+    if (stat(pathName.c_str(), &status) != 0)
+        return (false);
+
+    MappedFile  mapping (cacheFile(pathName));
+
+    if (!mapping.mapped())
+        return (false);
+
+    Reader  input (mapping.data(), mapping.size());
+
+    // check the header
+
+    char                header[sizeof(magic)];
+    unsigned            format;
+    unsigned long long  size, seconds, nanoseconds, contentHash;
+
+    if (!input.get(header, sizeof(header)) || memcmp(header, magic, sizeof(magic)) != 0)
+        return (false);
+
+    if (!input.get32(format) || format != version)
+        return (false);
+
+    if (!input.get64(size) || !input.get64(seconds) || !input.get64(nanoseconds) || !input.get64(contentHash))
+        return (false);
+
+    if (size != length || size != (unsigned long long) status.st_size)
+        return (false);
+
+    if (seconds != (unsigned long long) status.st_mtim.tv_sec || nanoseconds != (unsigned long long) status.st_mtim.tv_nsec)
+        if (contentHash != hash(text, length))
+            return (false);
+
+    // intern the tag names
+
+    vector< Html::Tag >     tags;
+
+    for (Html::Tag tag = 0; tag < Html::Markup::known; ++tag)
+        tags.push_back(tag);
+
+    unsigned    tagCount;
+
+    if (!input.get32(tagCount))
+        return (false);
+
+    for (unsigned ii = 0; ii < tagCount; ++ii)
+    {
+        string  name;
+
+        if (!input.getString(name))
+            return (false);
+
+        tags.push_back(Html::Markup::intern(name));
+    }
+
+    // rebuild the parse tree
+
+    if (!readElement(input, html, tags) || !input.atEnd())
+    {
+        html = Html::Element();
+
+        return (false);
+    }
+
+    return (true);
+}
+
+//----  save the parse tree to the cache file
+
+void    Cache::save (const string& pathName, const char* text, size_t length, const Html::Element& html)
+{
+    struct stat     status;
+
+    if (stat(pathName.c_str(), &status) != 0)
+        return;
+
+    // serialise the tree first to learn which tags it uses
+
+    Writer  tree;
+
+    map< Html::Tag, Html::Tag >     tags;
+
+    writeElement(tree, html, tags);
+
+    Writer  header;
+
+    header.put(magic, sizeof(magic));
+    header.put32(version);
+    header.put64(length);
+    header.put64(status.st_mtim.tv_sec);
+    header.put64(status.st_mtim.tv_nsec);
+    header.put64(hash(text, length));
+
+    vector< string >    names (tags.size());
+
+    for (map< Html::Tag, Html::Tag >::const_iterator it = tags.begin(); it != tags.end(); ++it)
+        names[it->second - Html::Markup::known] = Html::Markup::name(it->first);
+
+    header.put32(names.size());
+
+    for (size_t ii = 0; ii < names.size(); ++ii)
+        header.putString(names[ii]);
+
+    // write a temporary file and rename it
+
+    mkdir(cacheDirectory(pathName).c_str(), 0777);
+
+    const string    fileName (cacheFile(pathName));
+
+    char    suffix[32];
+
+    sprintf(suffix, ".%d", (int) getpid());
+
+    const string    tempName (fileName + suffix);
+
+    {
+        ofstream    output (tempName.c_str(), ios_base::out | ios_base::binary | ios_base::trunc);
+
+        if (!output)
+            return;
+
+        output.write(header.contents().data(), header.contents().length());
+        output.write(tree.contents().data(), tree.contents().length());
+        output.close();
+
+        if (!output)
+        {
+            unlink(tempName.c_str());
+            return;
+        }
+    }
+
+    if (rename(tempName.c_str(), fileName.c_str()) != 0)
+        unlink(tempName.c_str());
+}
+
+//----------------------------------------------------------------------------//
+//
+// Helper routines.
+//
+//----------------------------------------------------------------------------//
+
+//----  return the cache directory for the cribsheet
+
+string  Cache::cacheDirectory (const string& pathName)
+{
+    const size_t    pos = pathName.rfind("/");
+
+    if (pos == string::npos)
+        return (".cribcache");
+
+    return (pathName.substr(0, pos + 1) + ".cribcache");
+}
+
+//----  return the cache file for the cribsheet
+
+string  Cache::cacheFile (const string& pathName)
+{
+    const size_t    pos = pathName.rfind("/");
+
+    return (cacheDirectory(pathName) + "/" + pathName.substr(pos == string::npos ? 0 : pos + 1) + ".bin");
+}
+
+//----  FNV-1a hash of the cribsheet contents
+
+unsigned long long  Cache::hash (const char* text, size_t length)
+{
+    unsigned long long  value = 14695981039346656037ULL;
+
+    for (size_t ii = 0; ii < length; ++ii)
+    {
+        value ^= (unsigned char) text[ii];
+        value *= 1099511628211ULL;
+    }
+
+    return (value);
+}
+
+//----  write an element and its subelements
+
+void    Cache::writeElement (Writer& output, const Html::Element& element, map< Html::Tag, Html::Tag >& tags)
+{
+    typedef pair< const Html::Element*, size_t >    Position;   // an element and its next part
+
+    vector< Position >  stack (1, Position (&element, 0));
+
+    writeHeader(output, element, tags);
+
+    while (!stack.empty())
+    {
+        Position&                       position = stack.back();
+        const Html::ElementContents&    contents = position.first->contents;
+
+        if (position.second == contents.size())
+        {
+            stack.pop_back();
+            continue;
+        }
+
+        const Html::ElementPart&    part = contents[position.second++];
+
+        output.put8(part.subElement != 0);
+        output.putString(part.text);
+
+        if (part.subElement)
+        {
+            writeHeader(output, *part.subElement, tags);
+            stack.push_back(Position (part.subElement, 0));
+        }
+    }
+}
+
+//----  write the tag, flags and part count of an element
+
+void    Cache::writeHeader (Writer& output, const Html::Element& element, map< Html::Tag, Html::Tag >& tags)
+{
+    Html::Tag   tag = element.tag;
+
+    if (tag >= Html::Markup::known)
+    {
+        map< Html::Tag, Html::Tag >::const_iterator     it = tags.find(tag);
+
+        if (it == tags.end())
+            it = tags.insert(make_pair(tag, (Html::Tag) (Html::Markup::known + tags.size()))).first;
+
+        tag = it->second;
+    }
+
+    output.put32(tag);
+    output.put8(element.strictOrder | element.endOfSentence << 1 | element.startOfSentence << 2 | element.extraNewLine << 3 | element.lineBefore << 4 | element.lineAfter << 5);
+    output.put32(element.padWidth);
+    output.put32(element.contents.size());
+}
+
+//----  read an element and its subelements
+
+bool    Cache::readElement (Reader& input, Html::Element& element, const vector< Html::Tag >& tags)
+{
+    typedef pair< Html::Element*, unsigned >    Position;   // an element and the number of its parts yet to be read
+
+    unsigned    partCount;
+
+    if (!readHeader(input, element, tags, partCount))
+        return (false);
+
+    vector< Position >  stack (1, Position (&element, partCount));
+
+    while (!stack.empty())
+    {
+        Position&   position = stack.back();
+
+        if (position.second == 0)
+        {
+            stack.pop_back();
+            continue;
+        }
+
+        --position.second;
+
+        Html::ElementContents&  contents = position.first->contents;
+        unsigned char           flags;
+
+        if (!input.get8(flags))
+            return (false);
+
+        Html::Element*  subElement = (flags & 1) ? new Html::Element : 0;
+
+        contents.push_back(Html::ElementPart (subElement));
+
+        if (!input.getString(contents.back().text))
+            return (false);
+
+        if (subElement)
+        {
+            if (!readHeader(input, *subElement, tags, partCount))
+                return (false);
+
+            stack.push_back(Position (subElement, partCount));
+        }
+    }
+
+    return (true);
+}
+
+//----  read the tag, flags and part count of an element
+
+bool    Cache::readHeader (Reader& input, Html::Element& element, const vector< Html::Tag >& tags, unsigned& partCount)
+{
+    unsigned        tag, padWidth;
+    unsigned char   flags;
+
+    if (!input.get32(tag) || tag >= tags.size())
+        return (false);
+
+    if (!input.get8(flags) || !input.get32(padWidth) || !input.get32(partCount))
+        return (false);
+
+    if (partCount > input.remaining() / partSize)
+        return (false);
+
+    element.tag             = tags[tag];
+    element.strictOrder     = flags & 1;
+    element.endOfSentence   = flags & 2;
+    element.startOfSentence = flags & 4;
+    element.extraNewLine    = flags & 8;
+    element.lineBefore      = flags & 16;
+    element.lineAfter       = flags & 32;
+    element.padWidth        = padWidth;
+
+    element.contents.reserve(partCount);
+
+    return (true);
+}
+
+// EOF
@@ -0,0 +1,59 @@
+# ifndef    _CACHE_H
+# define    _CACHE_H
+
+//----------------------------------------------------------------------------//
+//
+// Interface file for the Cache namespace of the cribtutor program.
+//
+// The cribtutor program parses, massages and annotates every cribsheet every
+// time it is run, even when the cribsheet has not changed since the last run.
+//
+// The Cache namespace saves the final parse tree of a cribsheet to a file and
+// loads it from there the next time, provided the cribsheet is unchanged.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include "Html.h"
+
+#include <string>
+
+using namespace std;
+
+//----------------------------------------------------------------------------//
+//
+// There are two interface routines.  Both are passed:
+//    - pathName - the path name of the cribsheet
+//    - text, length - the contents of the cribsheet (usually a mapping)
+//    - html - the parse tree of the cribsheet
+//
+// Cache::load() loads html, which must be empty, from the cache file of the
+// cribsheet.  It returns false, leaving html empty, when there is no cache
+// file or the cache file is out of date or unusable.
+//
+// Cache::save() saves html, which must have just been created by parsing the
+// cribsheet, to the cache file of the cribsheet.  Failure is silent.
+//
+// The cache file of dir/name.html is dir/.cribcache/name.html.bin.  It is up
+// to date when the size and modification time of the cribsheet are those
+// recorded in the file or, failing that, when the hash of the contents is.
+//
+// For implementation details see Cache.cpp.
+//
+//----------------------------------------------------------------------------//
+
+namespace       Cache
+{
+    extern  bool    load (const string& pathName, const char* text, size_t length, Html::Element& html);
+
+    extern  void    save (const string& pathName, const char* text, size_t length, const Html::Element& html);
+};
+
+# endif  /* _CACHE_H */
@@ -22,6 +22,7 @@
 //
 //----------------------------------------------------------------------------//
 
+#include "Allocs.h"
 #include "Dialogue.h"
 #include "Terms.h"
 
@@ -70,19 +71,23 @@ namespace   Dialogue
         cout << ",";
     }
 
-    void    printTermSet (const Terms::MaskedTermSet& terms)
+    void    printTermSet (Terms::MaskedTermSet::const_iterator first, Terms::MaskedTermSet::const_iterator last)
     {
-        for_each(terms.begin(), terms.end(), printTerm);
+        for (; first != last; ++first)
+            printTerm(**first);
 
         cout << "\b;";
     }
 
     void    printTermList (const Terms::MaskedTermList& terms)
     {
-        for_each (terms.begin(), terms.end(), printTermSet);
+        size_t  first = 0;
+
+        for (vector< size_t >::const_iterator end = terms.ends.begin(); end != terms.ends.end(); first = *end++)
+            printTermSet (terms.terms.begin() + first, terms.terms.begin() + *end);
     }
 
-    // the masked terms is hierarchy that suits a for each approach
+    // the masked terms are sets, one after another, of compound terms
 
     ostream& operator<< (ostream &stream, const Terms::MaskedTermList& terms)
     {
@@ -109,6 +114,8 @@ namespace       Dialogue
 
 bool    Dialogue::yesNo (const string& header, const string& prompt)
 {
+    Allocs::Scope   scope (Allocs::dialogue);
+
     if (cin)
     {
         cout << header << endl;
@@ -153,6 +160,8 @@ bool    Dialogue::yesNo (const string& header, const string& prompt)
 
 void    Dialogue::fillInTheBlanks (const Html::Element& element, Quiz::ContentsList& sourceTerms, const int choices, bool& goodResponse)
 {
+    Allocs::Scope   scope (Allocs::dialogue);
+
     int     termCount = sourceTerms.size();
 
     if (choices == 0 || 2 * termCount < choices)
@@ -165,14 +174,22 @@ void    Dialogue::fillInTheBlanks (const Html::Element& element, Quiz::ContentsL
     {
         // ask the user to fill in the blanks until they get it right or give up
 
+        // the paragraph is rendered once and only the blanks change between attempts
+
+        const Html::Rendering   rendering (element);
+
+        // and its terms compiled once into the answers expected
+
+        Terms::AnswerKey    answerKey (sourceTerms);
+
         Terms::MaskedTermList  maskedTerms;
         int blankedCount;
 
         do
         {
-            blankedCount = Terms::mask(maskedTerms, sourceTerms, termCount, choices);
+            blankedCount = Terms::mask(maskedTerms, answerKey, choices);
 
-            cout << element << endl;
+            cout << rendering << endl;
 
             Html::Element*    lastSubelement = (element.contents.end() - 1)->subElement;
 
@@ -200,12 +217,17 @@ void    Dialogue::fillInTheBlanks (const Html::Element& element, Quiz::ContentsL
 // A response of ? gives a peek at the expected answer.  The user does not
 // get to try again.
 //
+// With --typo, a response with typos is accepted but the user is shown the
+// expected answer and the response does not count as a good one.
+//
 // The user may simply try again without answering the prompt.
 //
 //----------------------------------------------------------------------------//
 
 bool    Dialogue::tryAgain (const Terms::MaskedTermList& maskedTerms, const int termCount, bool& goodResponse)
 {
+    Allocs::Scope   scope (Allocs::dialogue);
+
     string  response;
 
     // ask nicely
@@ -221,7 +243,9 @@ bool    Dialogue::tryAgain (const Terms::MaskedTermList& maskedTerms, const int
 
     // empty response means skip - check otherwise
 
-    while (!response.empty() && !Terms::check(maskedTerms, response))
+    int     typos = 0;
+
+    while (!response.empty() && !Terms::check(maskedTerms, response, &typos))
     {
         if (response != "?" && response != "q")
         {
@@ -261,6 +285,15 @@ bool    Dialogue::tryAgain (const Terms::MaskedTermList& maskedTerms, const int
         }
     }
 
+    // near enough - but say so
+
+    if (typos > 0 && !response.empty())
+    {
+        goodResponse = false;
+
+        cout << "    Typo ... >>" << maskedTerms << endl;
+    }
+
     // don't try again
 
     if (!cin)
@@ -0,0 +1,46 @@
+# ifndef    _ESCAPES_H
+# define    _ESCAPES_H
+
+//----------------------------------------------------------------------------//
+//
+// Interface file for the Html::Escapes namespace of the cribtutor program.
+//
+// The html parser replaces character references (&lt;, &#60;, &#x3C; and so
+// on) in the text of a cribsheet with the characters they represent.  The
+// Html::Escapes namespace does the replacing.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include <string>
+
+using namespace std;
+
+//----------------------------------------------------------------------------//
+//
+// There is one interface routine:  Html::Escapes::replace().  It replaces, in
+// place, every character reference in its parameter and returns it.
+//
+// Named references are those of html5.  Numeric references, decimal and hex,
+// may be for any Unicode character.  Characters are UTF-8 encoded.
+//
+// For implementation details see Escapes.cpp.
+//
+//----------------------------------------------------------------------------//
+
+namespace       Html
+{
+    namespace   Escapes
+    {
+        extern  string& replace (string &statement);
+    };
+};
+
+# endif  /* _ESCAPES_H */
@@ -0,0 +1,115 @@
+//----------------------------------------------------------------------------//
+//
+// Implementation file for the Footprint namespace of the cribtutor program.
+//
+// The Footprint namespace measures the memory taken by a parse tree.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include "Footprint.h"
+
+#include <vector>
+
+#include <sys/resource.h>
+
+using namespace std;
+
+//----------------------------------------------------------------------------//
+//
+// See Footprint.h for a description of the interface.
+//
+// A string holds short text within itself and only longer text on the heap.
+// Which is the case is decided by where its data lies, not by its length, as
+// the threshold depends on the implementation of the standard library.
+//
+// The tree is walked with an explicit stack, not by recursion, so that a
+// deeply nested cribsheet cannot exhaust the call stack.
+//
+//----------------------------------------------------------------------------//
+
+namespace       Footprint
+{
+    static  bool    onHeap (const string& text);
+
+    static  long    peakResident (void);
+};
+
+//----  add the memory taken by an element and its subelements
+
+void    Footprint::measure (const Html::Element& element, Usage& usage)
+{
+    vector< const Html::Element* >  stack (1, &element);
+
+    while (!stack.empty())
+    {
+        const Html::Element&    next = *stack.back();
+
+        stack.pop_back();
+
+        usage.elements += 1;
+        usage.parts += next.contents.size();
+        usage.partSlots += next.contents.capacity();
+
+        for (Html::ElementContents::const_iterator it = next.contents.begin(); it != next.contents.end(); ++it)
+        {
+            if (onHeap(it->text))
+            {
+                usage.texts += 1;
+                usage.textBytes += it->text.capacity() + 1;
+            }
+
+            if (it->subElement)
+                stack.push_back(it->subElement);
+        }
+    }
+}
+
+//----  print the memory taken by a parse tree
+
+void    Footprint::report (ostream& stream, const string& pathName, const Html::Element& element)
+{
+    Usage   usage;
+
+    measure(element, usage);
+
+    stream << "Memory used by '" << pathName << "':" << endl;
+    stream << "    elements: " << usage.elements << " of " << sizeof(Html::Element) << " bytes = " << usage.elementBytes() << " bytes" << endl;
+    stream << "    parts:    " << usage.parts << " in " << usage.partSlots << " slots of " << sizeof(Html::ElementPart) << " bytes = " << usage.partBytes() << " bytes" << endl;
+    stream << "    texts:    " << usage.texts << " on the heap = " << usage.textBytes << " bytes" << endl;
+    stream << "    total:    " << usage.totalBytes() << " bytes" << endl;
+    stream << "    peak resident set: " << peakResident() << " kB" << endl;
+}
+
+//----  is the text of a string held on the heap ?
+
+bool    Footprint::onHeap (const string& text)
+{
+    const char*     data = text.data();
+
+    if (text.capacity() == 0)
+        return (false);
+
+    return (data < (const char *) &text || data >= (const char *) (&text + 1));
+}
+
+//----  the peak resident set size of the program in kB
+
+long    Footprint::peakResident (void)
+{
+    struct rusage   usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return (0);
+
+    return (usage.ru_maxrss);
+}
+
+// EOF
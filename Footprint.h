@@ -0,0 +1,77 @@
+# ifndef    _FOOTPRINT_H
+# define    _FOOTPRINT_H
+
+//----------------------------------------------------------------------------//
+//
+// Interface file for the Footprint namespace of the cribtutor program.
+//
+// The parse tree of a large cribsheet takes many times the size of the
+// cribsheet in memory.  The Footprint namespace measures how much and where
+// it goes so that the layout of the tree can be judged by numbers.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include "Html.h"
+
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+//----------------------------------------------------------------------------//
+//
+// The Usage structure counts the memory a parse tree takes:
+//    - elements - the Element objects (allocated from an arena)
+//    - parts - the ElementPart objects in use and the slots allocated for
+//      them (the contents vectors of the elements)
+//    - texts - the text strings held on the heap (short strings are held
+//      within their ElementPart) and the bytes allocated for them
+//
+// Footprint::measure() adds the memory taken by a parse tree to a Usage.
+//
+// Footprint::report() measures a parse tree and prints the usage together
+// with the peak resident set size of the program so far.  Its output is for
+// people, not programs, and it is printed with the --mem-stats flag.
+//
+// Bytes are those requested from the allocator:  allocator overheads are not
+// included.
+//
+//----------------------------------------------------------------------------//
+
+namespace       Footprint
+{
+    struct      Usage
+    {
+        size_t      elements;
+        size_t      parts;
+        size_t      partSlots;
+        size_t      texts;
+        size_t      textBytes;
+
+        Usage () :
+            elements (0),
+            parts (0),
+            partSlots (0),
+            texts (0),
+            textBytes (0)
+            {}
+
+        size_t  elementBytes (void) const   { return (elements * sizeof(Html::Element)); }
+        size_t  partBytes (void) const      { return (partSlots * sizeof(Html::ElementPart)); }
+        size_t  totalBytes (void) const     { return (elementBytes() + partBytes() + textBytes); }
+    };
+
+    extern  void    measure (const Html::Element& element, Usage& usage);
+
+    extern  void    report (ostream& stream, const string& pathName, const Html::Element& element);
+};
+
+# endif  /* _FOOTPRINT_H */
@@ -18,14 +18,21 @@
 //
 //----------------------------------------------------------------------------//
 
+#include "Allocs.h"
+#include "Escapes.h"
 #include "Html.h"
+#include "Lock.h"
 #include "Massage.h"
+#include "Stats.h"
+#include "Tokenizer.h"
 
 #include <cctype>
+#include <cstring>
 
-#include <fstream>
 #include <map>
 #include <iostream>
+#include <new>
+#include <sstream>
 
 using namespace std;
 
@@ -35,8 +42,12 @@ using namespace std;
 //
 // The html namespace offers two external routines, one to parse the html in
 // a cribsheet file and another to print elements the resultant parse tree.
+// The Builder class lets readers of other mark-up share the parse.
 //
-// The routines handle nested elements by recursion.
+// Nested elements are handled with an explicit stack, not by recursion, so
+// that the depth of nesting is not limited by the call stack:  the parse keeps
+// the Contexts of the elements open on a ContextStack, and printing and the
+// other walks of the tree keep the elements still to visit on a vector.
 //
 // The many helper routines hide ugly details to keep the principal routines
 // simple.  Most have a single call site.
@@ -45,22 +56,35 @@ using namespace std;
 
 namespace       Html
 {
-    // the routines that actually read from the input.
+    struct  Annotation;
+    struct  Context;
+    class   ContextStack;
 
-    static  string& readToNextTag  (istream& input, string &content);
-    static  string& readTag        (istream& input, string &tag, string &content, const string &endTag);
-    static  string& readComment    (istream& input, string &comment, const string& content);
-    inline  void    swallowNewLines(istream& input, bool condition);
+    // routine to parse an element and its nested sub elements
+
+    static  void    parseElement (Tokenizer &input, Context& outermost);
 
     // routines that create Element and ElementPart objects
 
-    static  Element*    newElement (istream& input, const string &tag);
-    static  void    addSubelement (istream& input, Element& parent, Element& element, string& content);
+    static  Element*    newElement (Tokenizer& input, const Tag tag);
+    static  void    addSubelement (Tokenizer& input, Context& context, Context& subContext, string& content);
+
+    // routines that place sub elements in the parse tree
+
+    static  void    openSubElement  (Context& context, string& content, Context& subContext);
+    static  void    closeSubElement (Context& context, Context& subContext);
+    static  void    addText (Context& context, string& content);
+
+    static  void    placeSubElement (Context& subContext, Annotation& owner, string& content);
+    static  bool    placeElement (Context& context, string& text, Context* first);
+    static  void    closeParagraph (Context& context);
+    static  void    closeCodeSpan (Context& context);
+    static  void    publishChapter (Chapters& chapters, Element& element, const size_t keep);
 
     // helper routines with a single call site in parseElement()
 
     inline  bool    unexpectedCloseTag  (const string &tag, string& content);
-    inline  bool    unexpectedNestedTag (const string &tag, const string &previous, string& content);
+    inline  bool    unexpectedNestedTag (const string &tag, const Tag value, const Tag previous, string& content);
 
     inline  bool    checkImageElement (string &tag);
     inline  void    stripAttributes   (string &tag);
@@ -68,17 +92,23 @@ namespace       Html
 
     //------
 
-    // annotate and tidy the parse tree
+    // routines that annotate the parts of an element as they are added
 
-    static  void    annotateElement (Element& element, bool htmlBlockElement = true);
+    static  void    openPart  (Annotation& annotation, string& content, Element& subElement);
+    static  void    closePart (Annotation& annotation, Element& subElement);
+    static  void    closeText (Annotation& annotation, const bool endOfElement);
+    static  void    closeElement (Annotation& annotation);
 
-    // helper routines for annotateElement()
+    // helper routines for the annotation
 
-    static  void    tidyText (string& content, const string &tag, const bool startOfElement, const bool endOfElement);
+    static  void    annotateText (Annotation& annotation, string& text, const size_t index, const bool endOfElement);
+    static  void    clearStrictOrder (Element& element);
+    static  void    compactContents (ElementContents& contents);
+    static  void    tidyText (string& content, const Tag tag, const bool startOfElement, const bool endOfElement);
     static  void    checkForPairedTerms (ElementPart& lhs, ElementPart& rhs);
     static  size_t  itemTabStop (Element& subElement);
 
-    // simple routines for annotateElement()
+    // simple routines for the annotation
 
     inline  bool    endOfSentence (const string& content);
     inline  bool    startOfSentence (const Element& parent, const string& content, const size_t index);
@@ -89,11 +119,13 @@ namespace       Html
 
     //------
 
-    // recursive routine to print an element and its nested sub elements
+    // routine to print an element and its nested sub elements
+
+    struct  Printing;
 
-    static  int     printElement (ostream &stream, const Element& element, string indent = "");
+    extern  int     printElement (ostream &stream, const Element& element, Rendering* rendering = 0);
 
-    // html is hierarchy that requires a recursive print routine
+    // html is hierarchy that requires a print routine that walks it
 
     extern  ostream& operator<< (ostream &stream, const Element& element)
     {
@@ -107,84 +139,385 @@ namespace       Html
 
 //----------------------------------------------------------------------------//
 //
-// The Html::Escapes namespace encapsulates the substitution of html escape
-// sequences (&apos etc.).
+// The Html::Comment namespace holds the text that opens and closes an html
+// comment.  Only the parser and the raw print need it.
 //
 //----------------------------------------------------------------------------//
 
 namespace       Html
 {
-    namespace   Escapes
+    namespace   Comment
     {
-        string& replace (string &statement);
+        static  const string    beg ("<!--");
+        static  const string    end ("-->");
     };
 };
 
 //----------------------------------------------------------------------------//
 //
-// The external routine of the html parser hides from the caller that the
-// parsing is a three pass process.
+// Tags are interned:  each distinct tag is given a small integer value the
+// first time it is seen and the same value thereafter.
+//
+// The table is preloaded with the tags the program recognises so that they
+// have the fixed values of the enumeration in Html.h.  The order of the names
+// below must match the order of the enumeration.
 //
-// The first pass reads the html file and parses the contents in a mechanical
-// fashion.
+// Values are never reused so the table stops growing when it reaches unknown:
+// tags met after that are not added and all have the name "<?>".
 //
-// The final pass annotates the parse tree with indications to printElement()
+// Cribsheets may be parsed in several threads at once so the table is shared
+// under a mutex.  It is never destroyed, so that it remains usable by threads
+// still parsing while the program exits.
+//
+//----------------------------------------------------------------------------//
+
+namespace
+{
+    const char*     knownTags[] =
+    {
+        "<>", "<h1>", "<h2>", "<h3>", "<p>", "<em>", "<pre>", "<div>", "<code>",
+        "<span>", "<ul>", "<ol>", "<li>", "<br>", "<hr>", "<a>", "<pre><code>", "<!--"
+    };
+
+    struct  TagTable
+    {
+        map< string, Html::Tag >    values;
+        deque< string >             names;
+        const string                unknownName;
+
+        TagTable () : unknownName ("<?>")
+        {
+            for (size_t ii = 0; ii < sizeof(knownTags) / sizeof(knownTags[0]); ++ii)
+                add(knownTags[ii]);
+        }
+
+        Html::Tag   add (const string& name)
+        {
+            if (names.size() >= Html::Markup::unknown)
+                return (Html::Markup::unknown);
+
+            const Html::Tag     tag = names.size();
+
+            values.insert(pair< string, Html::Tag > (name, tag));
+            names.push_back(name);
+
+            return (tag);
+        }
+    };
+
+    TagTable&   tagTable (void)
+    {
+        static  TagTable*   table = new TagTable;
+
+        return (*table);
+    }
+
+    pthread_mutex_t     tagTableMutex = PTHREAD_MUTEX_INITIALIZER;
+};
+
+//----  return the value of a tag, interning it if it is new
+
+Html::Tag   Html::Markup::intern (const string& name)
+{
+    Lock    lock (tagTableMutex);
+
+    TagTable&   table = tagTable();
+
+    map< string, Tag >::const_iterator  it = table.values.find(name);
+
+    if (it != table.values.end())
+        return (it->second);
+
+    return (table.add(name));
+}
+
+//----  return the text of a tag
+
+const string&   Html::Markup::name (Tag tag)
+{
+    Lock    lock (tagTableMutex);
+
+    const TagTable&     table = tagTable();
+
+    return (tag < table.names.size() ? table.names[tag] : table.unknownName);
+}
+
+//----------------------------------------------------------------------------//
+//
+// The parse of an element needs state of its own and state inherited from
+// the elements around it.  Two structures hold this.
+//
+// The Annotation structure holds the state of the annotation of the parts of
+// an element.  Parts are annotated as they are added so the state lives as
+// long as parts may be added:  usually for the parse of the element but, for
+// a paragraph that a list may yet be merged with, until the next element.
+// Text at the end of an element is held back until it is known to be the end.
+//
+// The Context structure holds the state of the parse of an element:  what the
+// massage rules (see Massage.h) have decided about it and the elements in it.
+//
+// The massage moves parts of one element into another:
+//    - a list (or asis block) is added to the paragraph before it or to a
+//      new paragraph
+//    - the parts of a paragraph after a list are added to the paragraph the
+//      list was added to
+//    - a Shuffle List comment that starts the first item of an ordered list
+//      is added to the list instead
+// The last two depend on the first part of the paragraph or list item so the
+// element is not placed in its parent until that is known:  it is undecided.
+//
+//----------------------------------------------------------------------------//
+
+struct  Html::Annotation
+{
+    Element*    element;
+
+    bool        htmlBlockElement;   // no paragraph encloses the element
+    bool        startOfElement;     // no text nor sub element, but comments, yet
+    bool        codeBlockSpecial;   // a code block with its indent dropped
+    bool        codeSpan;           // a code span, its text quoted in back ticks
+
+    size_t      listTabStop;        // for the items of an ordered list
+
+    bool        trailing;           // the element ends, so far, with text
+    string      text;               // that is not yet annotated
+
+    explicit Annotation (Element* element = 0, const bool htmlBlockElement = true) :
+        element (element),
+        htmlBlockElement (htmlBlockElement),
+        startOfElement (true),
+        codeBlockSpecial (false),
+        codeSpan (false),
+        listTabStop (0),
+        trailing (false)
+        {}
+
+    void    swap (Annotation& rhs)
+    {
+        std::swap(element, rhs.element);
+        std::swap(htmlBlockElement, rhs.htmlBlockElement);
+        std::swap(startOfElement, rhs.startOfElement);
+        std::swap(codeBlockSpecial, rhs.codeBlockSpecial);
+        std::swap(codeSpan, rhs.codeSpan);
+        std::swap(listTabStop, rhs.listTabStop);
+        std::swap(trailing, rhs.trailing);
+
+        text.swap(rhs.text);
+    }
+};
+
+struct  Html::Context
+{
+    Element&    element;
+    const Tag   tag;                // as parsed, before any renaming
+
+    Context*    parent;
+    Chapters*   chapters;           // to publish as they are parsed, if any
+
+    Annotation  own;                // of the element's parts
+    Annotation* annotation;         // the parts are added to:  own or that of the paragraph merged with
+    Annotation* owner;              // of the part that holds the element
+
+    bool        blockLevel;         // lists and asis blocks within get paragraphs
+    bool        codeSpans;          // code elements within are code spans
+    bool        shuffleList;        // the first item may start with a Shuffle List comment
+
+    bool        undecided;          // the element waits on its first part to be placed
+    bool        merged;             // the element's parts go to the paragraph before it
+    bool        hoisted;            // the comment goes to the list, not the list item
+    string      content;            // the text before the element, while undecided
+
+    Annotation  paragraph;          // the last paragraph, while a list may be merged with it
+    Tag         listTag;            // the last list, while a paragraph may be merged with it
+
+    explicit Context (Element& element) :
+        element (element),
+        tag (element.tag),
+        parent (0),
+        chapters (0),
+        own (&element),
+        annotation (&own),
+        owner (0),
+        blockLevel (false),
+        codeSpans (false),
+        shuffleList (false),
+        undecided (false),
+        merged (false),
+        hoisted (false),
+        listTag (Markup::none)
+        {}
+};
+
+//----------------------------------------------------------------------------//
+//
+// A ContextStack holds the Contexts of the elements open while parseElement()
+// parses.  The first, that of the top level element, is the caller's.  The
+// others are carved out of blocks set aside for them and reused as elements
+// close.
+//
+// Were each allocated from the heap in turn, the Contexts of a deeply nested
+// cribsheet would be interleaved with the parts of its parse tree, leaving
+// the tree scattered across the heap and slow to walk.
+//
+//----------------------------------------------------------------------------//
+
+class   Html::ContextStack
+{
+public:
+    explicit ContextStack (Context& context) : open (1, &context) {}
+   ~ContextStack ();
+
+public:
+    Context&    top (void)              { return (*open.back()); }
+    Context&    parent (void)           { return (*open[open.size() - 2]); }
+
+    size_t      depth (void) const      { return (open.size()); }
+
+    Context&    push (Element& element);
+    void        pop (void);
+
+private:
+    ContextStack (const ContextStack&);                 // not implemented
+    ContextStack& operator= (const ContextStack&);      // not implemented
+
+private:
+    static  const size_t    blockSize = 64;     // Contexts per block
+
+    vector< Context* >  open;       // the innermost last
+    vector< void* >     spare;      // storage for Contexts not in use
+    vector< void* >     blocks;     // all the storage, to be released
+};
+
+//----------------------------------------------------------------------------//
+//
+// The external routine of the html parser hides from the caller how the
+// parse is done.
+//
+// The parser reads the html file and parses the contents in a mechanical
+// fashion.  As it goes, it massages the parse tree in whatever manner may be
+// necessary or desirable and annotates it with indications to printElement()
 // of how the elements are to be printed.
 //
-// The intermediary pass is a hook that allows for the parse tree to be
-// altered in any manner that may be necessary or desirable.
+// These were once three passes over the parse tree.  Now each part of an
+// element is massaged and annotated as it is added, while the elements around
+// it are still to hand, so the parse tree is built in a single pass.
+//
+// The parser reads from memory.  A cribsheet that is read from a stream is
+// first read into memory in its entirety.
 //
 //----------------------------------------------------------------------------//
 
-void    Html::parseCribSheet (ifstream &input, Element &element)
+void    Html::parseCribSheet (const char* text, size_t length, Element &element, Chapters* chapters)
+{
+    Allocs::Scope   scope (Allocs::parse);
+
+    Tokenizer   input (text, length);
+
+    Context     context (element);
+
+    context.blockLevel = context.codeSpans = true;
+    context.chapters = chapters;
+
+    parseElement(input, context);
+
+    closeParagraph(context);
+
+    closeElement(context.own);
+
+    if (chapters && chapters->element)
+        publishChapter(*chapters, *chapters->element, 0);
+}
+
+void    Html::parseCribSheet (istream &input, Element &element, Chapters* chapters)
 {
-    parseElement(input, element);
+    Allocs::Scope   scope (Allocs::parse);
+
+    ostringstream   buffer;
 
-    massageElement(element);
+    buffer << input.rdbuf();
 
-    annotateElement(element);
+    const string    text (buffer.str());
+
+    parseCribSheet(text.data(), text.length(), element, chapters);
 }
 
 //----------------------------------------------------------------------------//
 //
-// Read and parse the cribsheet file - the first pass of the parse operation.
+// Read and parse the cribsheet file.
 //
 // The parser handles three distinct cases:
 //      - html comments (that may comment out other html elements)
 //      - open and close tags (with, by definition, no nested elements)
 //      - open tags and close tags, possibly separated by nested elements
 //
+// The elements open are kept on an explicit stack, not on the call stack, so
+// that machine generated cribsheets with very deep nesting do not overflow
+// it.  Their Contexts are held by a ContextStack and the tags that close them
+// alongside.  The text read so far belongs to the innermost element:  opening
+// a sub element always takes the text before it.
+//
 //----------------------------------------------------------------------------//
 
-void    Html::parseElement (istream &input, Element &element)
+void    Html::parseElement (Tokenizer &input, Context& outermost)
 {
-    string content;
+    ContextStack        contexts (outermost);       // the elements open
+    vector< string >    endTags (1, string ());     // the closing tag of each
 
-    string  endTag (element.tag);       // looking for this closing tag
-    endTag.insert(1, "/");
+    endTags.back().assign(Markup::name(outermost.tag)).insert(1, "/");
 
-    while (input.good())
-    {
-        readToNextTag (input, content);
+    string  content;
 
-        if (input.eof()) break;
+    for (;;)
+    {
+        Context&    context = contexts.top();
 
         string  tag;
 
-        readTag (input, tag, content, endTag);
+        if (input.atEnd() || !input.readToNextTag (content) || !input.readTag (tag) || tag == endTags.back())
+        {
+            // element ends with some text (an unexpected EOF leaves tag as text)
+
+            if (tag != endTags.back())
+                content += tag;
+
+            addText(context, content);
+
+            content.clear();
+
+            endTags.pop_back();
+
+            if (contexts.depth() == 1)
+                break;
+
+            closeSubElement(contexts.parent(), context);
+
+            if (lineAfterSubElement(context.element))
+                input.swallowNewLines();
+
+            contexts.pop();
 
-        if (tag == endTag) break;
+            continue;
+        }
 
         if (tag.compare(0, Comment::beg.length(), Comment::beg) == 0)
         {
-            string&     comment = readComment (input, tag, content);
+            string  comment;
+
+            input.readComment (comment);
 
-            Element&  subelement = * newElement (input, Comment::beg);
+            if (content.length() && isspace(content[content.length() - 1]))
+                input.swallowSpace();
 
-            addSubelement(input, element, subelement, content);
+            Element&  subelement = * newElement (input, Markup::comment);
+            Context   subContext (subelement);
 
             if (!comment.empty())
-                subelement.contents.push_back(ElementPart (comment));
+            {
+                subContext.own.trailing = true;
+                subContext.own.text.swap(comment);
+            }
+
+            addSubelement(input, context, subContext, content);
 
             continue;
         }
@@ -200,146 +533,560 @@ void    Html::parseElement (istream &input, Element &element)
 
         if (unexpectedCloseTag(tag, content)) continue;
 
-        if (openAndCloseTag(tag))
-        {
-            Element&  subelement = * newElement (input, tag);
+        if (openAndCloseTag(tag))
+        {
+            Element&  subelement = * newElement (input, Markup::intern(tag));
+            Context   subContext (subelement);
+
+            addSubelement(input, context, subContext, content);
+
+            continue;
+        }
+
+        const Tag   value = Markup::intern(tag);
+
+        if (unexpectedNestedTag(tag, value, context.tag, content)) continue;
+
+        // open tag followed by a separate close tag - parse any nested elements before closing it
+        {
+            Element&  subelement = * newElement (input, value);
+
+            openSubElement(context, content, contexts.push(subelement));
+
+            endTags.push_back(tag.insert(1, "/"));
+        }
+    }
+}
+
+//----  release the Contexts still open and the blocks that held them
+
+Html::ContextStack::~ContextStack ()
+{
+    while (open.size() > 1)
+        pop();
+
+    for (size_t ii = 0; ii < blocks.size(); ++ii)
+        operator delete (blocks[ii]);
+}
+
+//----  open the Context of a sub element
+
+Html::Context&  Html::ContextStack::push (Element& element)
+{
+    if (spare.empty())
+    {
+        char*   block = (char *) operator new (blockSize * sizeof(Context));
+
+        blocks.push_back(block);
+        spare.reserve(blocks.size() * blockSize);       // so that pop() need not allocate
+
+        for (size_t ii = blockSize; ii-- > 0; )
+            spare.push_back(block + ii * sizeof(Context));
+    }
+
+    Context*    context = new (spare.back()) Context (element);
+
+    spare.pop_back();
+    open.push_back(context);
+
+    return (*context);
+}
+
+//----  close the Context of the innermost sub element
+
+void    Html::ContextStack::pop (void)
+{
+    Context*    context = open.back();
+
+    open.pop_back();
+
+    context->~Context();
+
+    spare.push_back(context);
+}
+
+//----------------------------------------------------------------------------//
+//
+// Routines that create Element and ElementPart objects.
+//
+// newElement() creates a new element and addSubelement() adds a new element
+// with no nested elements to the parse tree.  An element with nested elements
+// is added in two steps, either side of their parse (see below).
+//
+// The calls to swallowNewLines() logically do not belong here but moving them
+// out would obscure the code in parseElement() and raise other 'to do or not
+// to do' questions.
+//
+//----------------------------------------------------------------------------//
+
+//----  parse sub-element that follows an open tag
+
+Html::Element*    Html::newElement (Tokenizer& input, const Tag tag)
+{
+    if (tag == Markup::asis || tag == Markup::newl || tag == Markup::comment)
+        input.swallowNewLines();
+
+    Element&  element = * (Element *) new Element (tag);
+
+    return (&element);
+}
+
+//----  add a new sub-element with no nested elements to the parse tree
+
+void    Html::addSubelement (Tokenizer& input, Context& context, Context& subContext, string& content)
+{
+    openSubElement(context, content, subContext);
+
+    closeSubElement(context, subContext);
+
+    if (lineAfterSubElement(subContext.element))
+        input.swallowNewLines();
+}
+
+//----------------------------------------------------------------------------//
+//
+// Routines that place sub elements in the parse tree, applying the massage
+// rules (see Massage.h) as they do.
+//
+// openSubElement() places a sub element before it is parsed so that its own
+// parts are annotated as they are parsed.  closeSubElement() ends the
+// annotation of the sub element and of the part that holds it.  addText()
+// adds the text at the end of an element.
+//
+// placeSubElement() adds the part that holds a sub element.  placeElement()
+// places an undecided element once its first part is known.  It returns
+// true if the first part is hoisted out of the element instead.
+//
+// A list is merged with the paragraph before it by adding the list to the
+// paragraph and the paragraph after it by adding its parts to the same
+// paragraph.  So the last paragraph of an element is not closed until the
+// next element shows no more parts are to be added to it.  This is the
+// parser's look-behind.  closeParagraph() closes it.
+//
+// Once a chapter header has been placed, the parts before it are done with.
+// publishChapter() moves them out to be published (see Html.h).
+//
+//----------------------------------------------------------------------------//
+
+//----  place a sub element before it is parsed
+
+void    Html::openSubElement (Context& context, string& content, Context& subContext)
+{
+    Allocs::Scope   scope (Allocs::massage);
+
+    Element&    subElement = subContext.element;
+
+    subContext.parent = &context;
+    subContext.chapters = context.chapters;
+
+    if (context.undecided && placeElement(context, content, &subContext))
+        return;
+
+    subContext.blockLevel = context.blockLevel && subElement.tag != Markup::para && !Markdown::wrapInParagraph(subElement.tag);
+    subContext.codeSpans  = context.codeSpans && !Markdown::codeBlock(context.element.tag, subElement.tag);
+
+    subContext.own.codeSpan = subContext.codeSpans && subElement.tag == Markup::code;
+
+    if (Markdown::codeBlock(context.element.tag, subElement.tag) && Markdown::renameCodeBlock(context.element.contents.empty(), content))
+    {
+        subElement.tag = Markup::asisCode;
+
+        subContext.own.codeBlockSpecial = true;
+    }
+
+    if (context.shuffleList)
+    {
+        context.shuffleList = false;
+
+        if (subElement.tag == Markup::item)
+        {
+            subContext.undecided = true;
+            subContext.content.swap(content);
+
+            return;
+        }
+    }
+
+    if (context.blockLevel && Markdown::wrapInParagraph(subElement.tag))
+    {
+        // merge with the paragraph before or push down into a paragraph of its own
+
+        Annotation&     paragraph = context.paragraph;
+
+        const Element*  before = context.element.contents.empty() ? 0 : context.element.contents.back().subElement;
+
+        if (before && before == paragraph.element)
+        {
+            const Element*  last = paragraph.trailing || before->contents.empty() ? 0 : before->contents.back().subElement;
+
+            if (Markdown::mergeWithList(last))
+            {
+                content = " ";
+
+                placeSubElement(subContext, paragraph, content);
+
+                subContext.shuffleList = subElement.tag == Markup::olst;
+
+                return;
+            }
+        }
+
+        closeParagraph(context);
+
+        Element&    newParagraph = * (Element *) new Element (Markup::para);
+
+        openPart(*context.annotation, content, newParagraph);
+
+        Annotation (&newParagraph, context.annotation->htmlBlockElement && context.element.tag != Markup::para).swap(paragraph);
+
+        placeSubElement(subContext, paragraph, content);
+
+        subContext.shuffleList = subElement.tag == Markup::olst;
+
+        return;
+    }
+
+    if (context.blockLevel && context.listTag != Markup::none && subElement.tag == Markup::para)
+    {
+        subContext.undecided = true;
+        subContext.content.swap(content);
+
+        return;
+    }
+
+    if (context.blockLevel)
+        closeParagraph(context);
+
+    placeSubElement(subContext, *context.annotation, content);
+
+    if (context.blockLevel && context.chapters && subElement.tag == context.chapters->tag)
+        publishChapter(*context.chapters, context.element, 1);
+}
+
+//----  end the annotation of a sub element and the part that holds it
+
+void    Html::closeSubElement (Context& context, Context& subContext)
+{
+    Allocs::Scope   scope (Allocs::massage);
+
+    Element&    subElement = subContext.element;
+
+    if (subContext.undecided)
+    {
+        string  none;
+
+        placeElement(subContext, none, 0);
+    }
+
+    if (subContext.merged)
+        return;
+
+    if (subContext.blockLevel)
+        closeParagraph(subContext);
+
+    if (subContext.own.codeSpan)
+        closeCodeSpan(subContext);
+
+    if (context.blockLevel && subElement.tag == Markup::para)
+    {
+        context.paragraph.swap(subContext.own);     // closed by closeParagraph()
+
+        return;
+    }
+
+    closeElement(subContext.own);
+
+    closePart(*subContext.owner, subElement);
+
+    if (context.blockLevel && Markdown::wrapInParagraph(subElement.tag))
+        context.listTag = subElement.tag;
+
+    if (subContext.hoisted)
+        placeSubElement(context, *context.parent->annotation, context.content);
+}
+
+//----  add the text at the end of an element
+
+void    Html::addText (Context& context, string& content)
+{
+    if (content.find_first_not_of(" \n\t") == string::npos)
+        return;
+
+    if (context.undecided)
+        placeElement(context, content, 0);
+
+    if (context.blockLevel)
+        closeParagraph(context);
+
+    Annotation&     annotation = *context.annotation;
+
+    annotation.trailing = true;
+    annotation.text.swap(content);
+}
+
+//----  add the part that holds a sub element
+
+void    Html::placeSubElement (Context& subContext, Annotation& owner, string& content)
+{
+    openPart(owner, content, subContext.element);
+
+    subContext.owner = &owner;
+
+    subContext.own.htmlBlockElement = owner.htmlBlockElement && owner.element->tag != Markup::para;
+}
+
+//----  place an undecided element given its first part (text and sub element, if any)
+
+bool    Html::placeElement (Context& context, string& text, Context* first)
+{
+    Allocs::Scope   scope (Allocs::massage);
+
+    Context&    parent = *context.parent;
+
+    context.undecided = false;
+
+    if (!parent.blockLevel)
+    {
+        // the first item of a list:  does it start with a Shuffle List comment ?
+
+        if (first && first->element.tag == Markup::comment && first->own.trailing && Markdown::shuffleComment(first->own.text))
+        {
+            placeSubElement(*first, *parent.annotation, text);
+
+            first->hoisted = true;
+
+            return (true);
+        }
+
+        placeSubElement(context, *parent.annotation, context.content);
+
+        return (false);
+    }
+
+    // a paragraph after a list:  does it start with a comment ?
+
+    if (Markdown::mergeWithParagraph(text, first ? &first->element : 0))
+    {
+        if (parent.listTag == Markup::ulst)
+            text.insert(0, " ");
+
+        context.annotation = &parent.paragraph;
+        context.merged = true;
+    }
+    else
+    {
+        closeParagraph(parent);
+
+        placeSubElement(context, *parent.annotation, context.content);
+    }
+
+    parent.listTag = Markup::none;
+
+    return (false);
+}
+
+//----  close the last paragraph of an element
+
+void    Html::closeParagraph (Context& context)
+{
+    Allocs::Scope   scope (Allocs::massage);
+
+    context.listTag = Markup::none;
+
+    if (context.paragraph.element == 0)
+        return;
+
+    Element&    paragraph = *context.paragraph.element;
+
+    closeElement(context.paragraph);
+
+    closePart(*context.annotation, paragraph);
+
+    Annotation ().swap(context.paragraph);
+}
+
+//----  quote a code span in back ticks but first split out any terms in it (see Massage.cpp)
+
+void    Html::closeCodeSpan (Context& context)
+{
+    Allocs::Scope   scope (Allocs::massage);
+
+    Annotation&     annotation = context.own;
+
+    vector< size_t >    delimiters;
+
+    if (context.element.contents.empty() && annotation.trailing && Markdown::termsInCodeSpan(annotation.text, delimiters))
+    {
+        string  codeSpan;
+
+        codeSpan.swap(annotation.text);
+
+        annotation.trailing = false;
+
+        context.blockLevel = context.codeSpans = false;
+
+        size_t  pos = 0;
+
+        for (size_t ii = 0; ii < delimiters.size(); ii += 2)
+        {
+            string      content (codeSpan, pos, delimiters[ii] - pos);
+            string      term (codeSpan, delimiters[ii] + 1, delimiters[ii + 1] - delimiters[ii] - 1);
+
+            Context     subContext (* (Element *) new Element (Markup::term));
+
+            openSubElement(context, content, subContext);
+
+            addText(subContext, term);
+
+            closeSubElement(context, subContext);
+
+            pos = delimiters[ii + 1] + 1;
+        }
+
+        string  content (codeSpan, pos);
+
+        addText(context, content);
+    }
+
+    if (annotation.trailing)
+    {
+        annotation.text += "`";
+    }
+    else if (!context.element.contents.empty())
+    {
+        annotation.trailing = true;
+        annotation.text = "`";
+    }
+}
+
+//----  publish the parts of the element that holds the chapters, all but the last few (see Html.h)
+
+void    Html::publishChapter (Chapters& chapters, Element& element, const size_t keep)
+{
+    if (chapters.element == 0)
+        chapters.element = &element;
+
+    if (chapters.element != &element)
+        return;
 
-            addSubelement(input, element, subelement, content);
+    Element&    chapter = * (Element *) new Element;
 
-            continue;
-        }
+    ElementContents&    contents = element.contents;
 
-        if (unexpectedNestedTag(tag, element.tag, content)) continue;
+    const size_t    parts = contents.size() - keep;
 
-        // open tag followed by a separate close tag - process any nested elements
-        {
-            Element&  subelement = * newElement (input, tag);
+    chapter.contents.resize(parts);
 
-            parseElement(input, subelement);
+    for (size_t ii = 0; ii < parts; ++ii)
+        chapter.contents[ii].swap(contents[ii]);
 
-            addSubelement(input, element, subelement, content);
-        }
-    }
+    for (size_t ii = 0; ii < keep; ++ii)
+        contents[ii].swap(contents[parts + ii]);
 
-    // element ends with some text
+    contents.resize(keep);
 
-    if (content.find_first_not_of(" \n\t") != string::npos)
-        element.contents.push_back(ElementPart (content));
+    (*chapters.publisher)(chapters.stream, chapter);
 }
 
 //----------------------------------------------------------------------------//
 //
-// The routines that actually read from the input.
-//
-// All but the last have a single call site in parseElement().  They are
-// implemented to cope gracefully with an unexpected end of file.
-//
-// The last routine is a bit of hack.
+// The Builder class drives the same routines as parseElement() but on behalf
+// of a reader of other mark-up.  It holds the stack of Context objects that
+// parseElement() holds while it parses.
 //
 //----------------------------------------------------------------------------//
 
-//----  read text upto the next html tag - append to any old content
+//----  start a parse tree
 
-string& Html::readToNextTag (istream& input, string &content)
+Html::Builder::Builder (Element& element, Chapters* chapters)
 {
-    string  buffer;
-
-    getline(input, buffer, '<');
+    Context*    context = new Context (element);
 
-    if (!input.eof())
-        input.putback('<');
+    context->blockLevel = context->codeSpans = true;
+    context->chapters = chapters;
 
-    content += buffer;
-
-    return (content);
+    contexts.push_back(context);
 }
 
-//----  read an html tag
+//----  release the contexts of any elements left open
 
-string& Html::readTag (istream& input, string &tag, string &content, const string &endTag)
+Html::Builder::~Builder ()
 {
-    getline(input, tag, '>');
+    for (size_t ii = 0; ii < contexts.size(); ++ii)
+        delete contexts[ii];
+}
 
-    if (input.eof())
-        content += tag, tag = endTag;   // unexpected EOF
-    else
-        tag += '>';
+//----  add text to the element last opened
 
-    return (tag);
+void    Html::Builder::text (const char* text, size_t length)
+{
+    content.append(text, length);
 }
 
-//----  read an html comment element and discard its tags
+//----  open a sub element of the element last opened
 
-string& Html::readComment (istream& input, string &comment, const string& content)
+void    Html::Builder::open (const Tag tag)
 {
-    comment.erase(0,Comment::beg.length());
+    Context*    subContext = new Context (* (Element *) new Element (tag));
 
-    while (comment.find(Comment::end) == string::npos)
-    {
-        string  buffer;
+    openSubElement(*contexts.back(), content, *subContext);
 
-        getline(input, buffer, '>');
-        if (input.eof())
-            buffer += "--";
-        buffer += '>';
+    contexts.push_back(subContext);
+}
 
-        comment += buffer;
-    }
+//----  close the element last opened
 
-    comment.erase(comment.length()-Comment::end.length(),string::npos);
+void    Html::Builder::close (void)
+{
+    Context*    subContext = contexts.back();
 
-    if (content.length() && isspace(content[content.length() - 1]))
-        while (!input.eof() && isspace(input.peek()))
-            input.get();
+    addText(*subContext, content);
 
-    return (comment);
-}
+    content.clear();
 
-//----  discard new lines from the input when condition is true
+    contexts.pop_back();
 
-void    Html::swallowNewLines (istream& input, bool condition)
-{
-    if (condition)
-        while (!input.eof() && input.peek() == '\n')
-            input.get();
-}
+    closeSubElement(*contexts.back(), *subContext);
 
-//----------------------------------------------------------------------------//
-//
-// Routines that create Element and ElementPart objects.
-//
-// newElement() creates a new element and addSubelement() adds the new element
-// to its parent's contents.
-//
-// There are two routines because there are cases where, in between, parsing
-// of nested elements is appropriate and other cases where it is not required.
-//
-// The calls to swallowNewLines() logically do not belong here but moving them
-// out would obscure the code in parseElement() and raise other 'to do or not
-// to do' questions.
-//
-//----------------------------------------------------------------------------//
+    delete subContext;
+}
 
-//----  parse sub-element that follows an open tag
+//----  add an html comment to the element last opened
 
-Html::Element*    Html::newElement (istream& input, const string &tag)
+void    Html::Builder::comment (const string& text)
 {
-    swallowNewLines (input, tag == Markup::asis || tag == Markup::newl || tag == Comment::beg);
+    Context     subContext (* (Element *) new Element (Markup::comment));
 
-    Element&  element = * (Element *) new Element (tag);
+    if (!text.empty())
+    {
+        subContext.own.trailing = true;
+        subContext.own.text = text;
+    }
 
-    return (&element);
+    openSubElement(*contexts.back(), content, subContext);
+
+    closeSubElement(*contexts.back(), subContext);
 }
 
-//----  add the new sub-element to its parent's contents
+//----  close the elements left open and end the parse tree
 
-void    Html::addSubelement (istream& input, Element& parent, Element& element, string& content)
+void    Html::Builder::finish (void)
 {
-    parent.contents.push_back(ElementPart (content, &element));
+    while (contexts.size() > 1)
+        close();
+
+    Context&    context = *contexts.back();
+
+    addText(context, content);
 
     content.clear();
 
-    swallowNewLines (input, lineAfterSubElement(element));
+    closeParagraph(context);
+
+    closeElement(context.own);
+
+    if (context.chapters && context.chapters->element)
+        publishChapter(*context.chapters, *context.chapters->element, 0);
 }
 
 //----------------------------------------------------------------------------//
@@ -376,9 +1123,9 @@ bool    Html::unexpectedCloseTag (const string &tag, string& content)
 
 //----  check for open tag nested within an element with the same open tag
 
-bool    Html::unexpectedNestedTag (const string &tag, const string &previous, string& content)
+bool    Html::unexpectedNestedTag (const string &tag, const Tag value, const Tag previous, string& content)
 {
-    if (tag == previous)
+    if (value == previous)
     {
         content += tag;     // treat tag as ordinary text for debugging purposes
         return (true);
@@ -393,9 +1140,9 @@ bool    Html::checkImageElement (string &tag)
 {
     string attribute;
 
-    if (tag.substr(0,5) == "<img ")
+    if (tag.compare(0, 5, "<img ") == 0)
         attribute = "alt=";
-    else if (tag.substr(0,7) == "<embed ")
+    else if (tag.compare(0, 7, "<embed ") == 0)
         attribute = "title=";
     else
         return (false);
@@ -460,182 +1207,321 @@ bool    Html::openAndCloseTag (string &tag)
         return (true);
     }
 
-    return (tag == Markup::newl || tag == Markup::rule);
+    return (tag == Markup::name(Markup::newl) || tag == Markup::name(Markup::rule));
 }
 
 //----------------------------------------------------------------------------//
 //
-// Annotate and tidy the parse tree - the third pass of the parse operation.
+// Annotate and tidy the parse tree.
 //
 // This is where policy is applied to the parse tree.  The policy determines
 // how the parse tree is printed.  Think of it as blank lines with attitude.
 // The print routine itself implements no policy.
 //
+// The parts of an element are annotated as they are added to it:
+//    - openPart() annotates the text before a sub element and what the sub
+//      element inherits from the element, before the sub element is parsed
+//    - closePart() annotates what the element learns from the sub element,
+//      once it is parsed
+//    - closeText() annotates text with no sub element, usually at the end
+//    - closeElement() annotates what depends on all the parts
+//
+// A sub element inherits its strict order when it is opened.  When it turns
+// out to be paired with the next sub element, it is too late for what it
+// contains so clearStrictOrder() clears their strict order too.
+//
 //----------------------------------------------------------------------------//
 
-void    Html::annotateElement (Element& element, bool htmlBlockElement)
+//----  add the part that holds a sub element and annotate it before the sub element is parsed
+
+void    Html::openPart (Annotation& annotation, string& content, Element& subElement)
 {
-    ElementContents::iterator   it;
+    Allocs::Scope   scope (Allocs::annotate);
 
-    size_t  index;
-    size_t  finalIndex = element.contents.size() - 1;
+    Element&    element = *annotation.element;
 
-    bool    startOfElement = true;
+    if (annotation.trailing)
+        closeText(annotation, false);
 
-    size_t  listTabStop = 0;
+    element.contents.push_back(ElementPart (&subElement));
 
-    bool    codeBlockSpecial = (element.tag == Markup::asis + Markup::code);
+    const size_t    index = element.contents.size() - 1;
 
-    for (it = element.contents.begin(), index = 0; it != element.contents.end(); ++it, ++index)
-    {
-        if (codeBlockSpecial && index == 0)
-            codeBlockSpecial = (it->text.substr(0,4) == "    ");
+    ElementPart&    part = element.contents[index];
 
-        if (!it->text.empty())
-        {
-            tidyText(it->text, codeBlockSpecial ? Markup::asis : element.tag, startOfElement, index == finalIndex && ! it->subElement);
+    part.text.swap(content);
 
-            Escapes::replace (it->text);
+    if (annotation.codeSpan && index == 0)
+        part.text.insert(0, "`");
 
-            startOfElement = false;
-        }
+    if (index > 0)
+        checkForPairedTerms (element.contents[index - 1], part);
 
-        if (it->subElement)
-        {
-            Element&    subElement = *it->subElement;
+    annotateText(annotation, part.text, index, false);
 
-            subElement.startOfSentence = startOfSentence(element, it->text, index);
-            subElement.extraNewLine    = extraNewLine(element, subElement);
-            subElement.strictOrder    &= element.strictOrder && subElement.tag != Markup::ulst;
+    subElement.startOfSentence = startOfSentence(element, part.text, index);
+    subElement.strictOrder    &= element.strictOrder && subElement.tag != Markup::ulst;
 
-            it->lineBeforeSubElement = lineBeforeSubElement(element, subElement, htmlBlockElement);
-            it->lineAfterSubElement  = lineAfterSubElement(subElement);
+    subElement.lineAfter  = lineAfterSubElement(subElement);
 
-            if (index != finalIndex)
-                checkForPairedTerms (*it, *(it + 1));
+    if (subElement.tag != Markup::comment)
+        annotation.startOfElement = false;
+}
 
-            annotateElement(subElement, htmlBlockElement && element.tag != Markup::para);
+//----  annotate the part that holds a sub element once the sub element is parsed
 
-            element.endOfSentence = subElement.endOfSentence;
+void    Html::closePart (Annotation& annotation, Element& subElement)
+{
+    Allocs::Scope   scope (Allocs::annotate);
 
-            if (subElement.tag == Markup::item && element.tag == Markup::olst && it->text.empty())
-                it->text = "  ";
+    Element&    element = *annotation.element;
 
-            if (subElement.tag != Comment::beg)
-                startOfElement = false;
+    subElement.extraNewLine = extraNewLine(element, subElement);
+    subElement.lineBefore   = lineBeforeSubElement(element, subElement, annotation.htmlBlockElement);
 
-            if (element.tag == Markup::olst && subElement.tag == Markup::item)
-            {
-                // suppose the list has items of the form:
-                //     term - description
-                // would it not be nice to line up the descriptions ?
+    element.endOfSentence = subElement.endOfSentence;
 
-                if (subElement.contents.size() == 1 && subElement.contents.front().subElement && subElement.contents.front().subElement->tag == Markup::para)
-                {
-                    listTabStop = max (listTabStop, itemTabStop (*subElement.contents.front().subElement));
-                }
-                else
-                {
-                    listTabStop = max (listTabStop, itemTabStop (subElement));
-                }
-            }
+    if (element.tag == Markup::olst && subElement.tag == Markup::item)
+    {
+        // suppose the list has items of the form:
+        //     term - description
+        // would it not be nice to line up the descriptions ?
+
+        if (subElement.contents.size() == 1 && subElement.contents.front().subElement && subElement.contents.front().subElement->tag == Markup::para)
+        {
+            annotation.listTabStop = max (annotation.listTabStop, itemTabStop (*subElement.contents.front().subElement));
         }
         else
         {
-            if (index == finalIndex)
-                element.endOfSentence = endOfSentence(it->text);
+            annotation.listTabStop = max (annotation.listTabStop, itemTabStop (subElement));
         }
     }
+}
+
+//----  add a part with no sub element and annotate it
+
+void    Html::closeText (Annotation& annotation, const bool endOfElement)
+{
+    Allocs::Scope   scope (Allocs::annotate);
+
+    Element&    element = *annotation.element;
+
+    element.contents.push_back(ElementPart ());
+
+    const size_t    index = element.contents.size() - 1;
+
+    string&     text = element.contents[index].text;
+
+    text.swap(annotation.text);
+
+    annotation.trailing = false;
+
+    if (annotation.codeSpan && index == 0)
+        text.insert(0, "`");
+
+    annotateText(annotation, text, index, endOfElement);
+
+    if (endOfElement)
+        element.endOfSentence = endOfSentence(text);
+}
+
+//----  annotate an element once all its parts have been added
+
+void    Html::closeElement (Annotation& annotation)
+{
+    Allocs::Scope   scope (Allocs::annotate);
+
+    Element&    element = *annotation.element;
+
+    if (annotation.trailing)
+        closeText(annotation, true);
 
     // apply the offset required to do the nice thing
 
     if (element.tag == Markup::olst)
-        for (it = element.contents.begin(); it != element.contents.end(); ++it)
+        for (ElementContents::iterator it = element.contents.begin(); it != element.contents.end(); ++it)
             if (it->subElement)
             {
                 Element&    subElement = *it->subElement;
 
                 if (subElement.tag == Markup::item)
                 {
+                    if (it->text.empty())
+                        it->text = "  ";
+
                     if (subElement.contents.size() == 1 && subElement.contents.front().subElement && subElement.contents.front().subElement->tag == Markup::para)
                     {
-                        subElement.contents.front().subElement->padWidth = listTabStop;
+                        subElement.contents.front().subElement->padWidth = annotation.listTabStop;
                     }
                     else
                     {
-                        subElement.padWidth = listTabStop;
+                        subElement.padWidth = annotation.listTabStop;
                     }
                 }
             }
+
+    compactContents(element.contents);
 }
 
 //----------------------------------------------------------------------------//
 //
-// Helper routines for annotateElement().
+// Helper routines for the annotation.
 //
 //----------------------------------------------------------------------------//
 
+//----  tidy the text of a part
+
+void    Html::annotateText (Annotation& annotation, string& text, const size_t index, const bool endOfElement)
+{
+    if (annotation.codeBlockSpecial && index == 0)
+        annotation.codeBlockSpecial = (text.compare(0, 4, "    ") == 0);
+
+    if (!text.empty())
+    {
+        tidyText(text, annotation.codeBlockSpecial ? (Tag) Markup::asis : annotation.element->tag, annotation.startOfElement, endOfElement);
+
+        Escapes::replace (text);
+
+        Stats::count(Stats::textBytes, text.length());
+
+        annotation.startOfElement = false;
+    }
+}
+
+//----  clear the strict order of an element and of those it contains
+
+void    Html::clearStrictOrder (Element& element)
+{
+    vector< Element* >  stack (1, &element);    // the elements yet to clear
+
+    while (!stack.empty())
+    {
+        Element&    next = *stack.back();
+
+        stack.pop_back();
+
+        next.strictOrder = false;
+
+        for (ElementContents::iterator it = next.contents.begin(); it != next.contents.end(); ++it)
+            if (it->subElement && it->subElement->strictOrder)
+                stack.push_back(it->subElement);
+    }
+}
+
+//----  release the capacity of the contents beyond their size - the parse is done with them
+//
+//  The parts are swapped into a vector of the exact size rather than copied so
+//  that their text is not copied too.
+
+void    Html::compactContents (ElementContents& contents)
+{
+    if (contents.capacity() == contents.size())
+        return;
+
+    ElementContents     exact (contents.size());
+
+    ElementContents::iterator   to = exact.begin();
+
+    for (ElementContents::iterator it = contents.begin(); it != contents.end(); ++it, ++to)
+        to->swap(*it);
+
+    contents.swap(exact);
+}
+
 //----  tidy the white space in the text content of html elements (and comments)
+//
+//  Both cases work in place in a single pass over the text.  Collapsing white
+//  space only ever shortens the text so the prose case writes behind the point
+//  it reads.  Indenting a code block only ever lengthens it so that case first
+//  counts the lines to indent, grows the string once and then works backwards
+//  from the end.
 
-void    Html::tidyText (string& content, const string &tag, const bool startOfElement, const bool endOfElement)
+void    Html::tidyText (string& content, const Tag tag, const bool startOfElement, const bool endOfElement)
 {
     if (content.length() == 0)
         return;
 
-    size_t pos;
-
-    if (tag != Markup::asis && tag != Markup::code && tag != Markup::asis + Markup::code && tag != Markup::span)
+    if (tag != Markup::asis && tag != Markup::code && tag != Markup::asisCode && tag != Markup::span)
     {
-        // convert new lines to spaces
+        // convert new lines and tabs to spaces and eliminate duplicate spaces
 
-        for (pos = content.find("\n"); pos != string::npos; pos = content.find("\n"))
-            content.replace(pos, 1, " ");
+        const size_t    length = content.length();
 
-        // convert tabs to spaces
+        size_t  out = 0;
 
-        for (pos = content.find("\t"); pos != string::npos; pos = content.find("\t"))
-            content.replace(pos, 1, " ");
+        for (size_t in = 0; in < length; ++in)
+        {
+            char    ch = content[in];
+
+            if (ch == '\n' || ch == '\t')
+                ch = ' ';
 
-        // eliminate duplicate spaces
+            if (ch == ' ' && out > 0 && content[out - 1] == ' ')
+                continue;
 
-        for (pos = content.find("  "); pos != string::npos; pos = content.find("  "))
-            content.replace(pos, 2, " ");
+            content[out++] = ch;
+        }
 
         // strip trailing space ?
 
-        if (endOfElement)
-        {
-            pos = content.length() - 1;
-            if (content[pos] == ' ')
-                content.erase(pos, 1);
-        }
+        if (endOfElement && content[out - 1] == ' ')
+            --out;
 
         // strip leading space ?
 
+        size_t  first = 0;
+
         if (startOfElement || tag == Markup::olst || tag == Markup::none)
-        {
-            pos = 0;
-            if (content[pos] == ' ')
-                content.erase(pos, 1);
-        }
+            if (out > 0 && content[0] == ' ')
+                first = 1;
+
+        content.erase(out);
+        content.erase(0, first);
     }
     else
     {
-        pos = content.length() - 1;
-        if (content[pos] == '\n')
-            content.erase(pos, 1);
+        if (content[content.length() - 1] == '\n')
+            content.erase(content.length() - 1);
 
-        if (tag == Markup::asis + Markup::code)
+        if (tag == Markup::asisCode)
         {
-            pos = 0;
+            // indent every line that is not empty by four spaces
+
+            const size_t    length = content.length();
+
+            const bool  indentFirst = startOfElement && length > 0 && content[0] != '\n' && content[0] != '\0';
+
+            size_t  indents = indentFirst ? 1 : 0;
+
+            for (size_t pos = 0; pos < length; ++pos)
+                if (content[pos] == '\n' && pos + 1 < length && content[pos + 1] != '\n' && content[pos + 1] != '\0')
+                    ++indents;
+
+            if (indents == 0)
+                return;
+
+            content.resize(length + 4 * indents);
 
-            if (startOfElement)
-                if (content[pos] != '\n' && content[pos] != '\0')
-                    content.insert(pos,"    ");
+            size_t  out = content.length();
+            char    next = '\0';
+
+            for (size_t in = length; in-- > 0; )
+            {
+                const char  ch = content[in];
+
+                if (ch == '\n' && next != '\n' && next != '\0')
+                {
+                    out -= 4;
+                    content.replace(out, 4, 4, ' ');
+                }
+
+                content[--out] = ch;
+
+                next = ch;
+            }
 
-            for (pos = content.find("\n"); pos++ != string::npos; pos = content.find("\n",pos))
-                if (content[pos] != '\n' && content[pos] != '\0')
-                   content.insert(pos,"    ");
+            if (indentFirst)
+                content.replace(0, 4, 4, ' ');
         }
     }
 }
@@ -644,7 +1530,7 @@ void    Html::tidyText (string& content, const string &tag, const bool startOfEl
 
 void    Html::checkForPairedTerms (ElementPart& lhs, ElementPart& rhs)
 {
-    static  string  joinText[] = {"/", " and ", " or "};
+    static  const char*     joinText[] = {"/", " and ", " or "};
 
     if (lhs.subElement == 0 || rhs.subElement == 0) return;
 
@@ -655,18 +1541,24 @@ void    Html::checkForPairedTerms (ElementPart& lhs, ElementPart& rhs)
     for (int ii = 0; ii < 3; ++ii)
         if (text == joinText[ii])
         {
-            lhs.subElement->strictOrder = rhs.subElement->strictOrder = false;
+            clearStrictOrder(*lhs.subElement);
+
+            rhs.subElement->strictOrder = false;
 
             break;
         }
-        else if (text.substr(0,joinText[ii].length()) == joinText[ii])
+        else if (text.compare(0, strlen(joinText[ii]), joinText[ii]) == 0)
         {
-            string  extra = text.substr(joinText[ii].length());
+            string  extra = text.substr(strlen(joinText[ii]));
 
             int     len = lhs.text.length() - extra.length();
 
             if (len > 0 && lhs.text.substr(len) == extra)
-                lhs.subElement->strictOrder = rhs.subElement->strictOrder = false;
+            {
+                clearStrictOrder(*lhs.subElement);
+
+                rhs.subElement->strictOrder = false;
+            }
         }
 }
 
@@ -694,7 +1586,7 @@ size_t  Html::itemTabStop (Element& element)
             }
         }
 
-        if (it->subElement && it->subElement->tag == Markup::term)
+        if (it->subElement && it->subElement->tag == Markup::term && !it->subElement->contents.empty())
         {
             tabStop += it->subElement->contents.front().text.length();
         }
@@ -705,7 +1597,7 @@ size_t  Html::itemTabStop (Element& element)
 
 //----------------------------------------------------------------------------//
 //
-// Simple helper routines for annotateElement().
+// Simple helper routines for the annotation.
 //
 // The bool return values of these routines are used to set 'state' flags in
 // Element or ElementPart objects.
@@ -790,7 +1682,7 @@ bool    Html::lineBeforeSubElement (const Element& parent, Element& element, con
     if (element.tag == Markup::olst)
         return (true);      // yes for a ordered list
 
-    if (element.tag == Comment::beg)
+    if (element.tag == Markup::comment)
         return (false);     // not for a comment
     if (element.tag == Markup::rule)
         return (false);     // not for a header rule
@@ -812,8 +1704,8 @@ bool    Html::lineAfterSubElement (const Element& element)
 
 //----------------------------------------------------------------------------//
 //
-// The html print operation is implemented in a single recursive routine:
-//    - printElement() prints an elements and, by recursion, its subelements.
+// The html print operation is implemented in a single routine:
+//    - printElement() prints an elements and its subelements.
 //
 // The format is appropriate for the cribtutor program.  It inserts only blank
 // lines.  It does not attempt to honour inline formatting such as italics.
@@ -821,163 +1713,315 @@ bool    Html::lineAfterSubElement (const Element& element)
 // The routine prints blanked terms using element.contentMask.  This mask is
 // set and cleared elsewhere.
 //
-// The verbose option is for debugging the parser.
+// The verbose option is for debugging the parser.  It indents each element
+// by two spaces more than the element that holds it.
+//
+// The elements being printed are kept on an explicit stack, not on the call
+// stack, as for the parse.  The Printing structure holds the state of the
+// print of each:  the part reached and how it ends so far.
 //
 //----------------------------------------------------------------------------//
 
-int     Html::printElement (ostream &stream, const Element& element, string indent)
+struct  Html::Printing
+{
+    const Element*                  element;
+    ElementContents::const_iterator it;         // the next part to print
+
+    bool    lineBetween;
+    bool    lineAfter;
+
+    int     textLength;
+
+    explicit Printing (const Element& element) :
+        element (&element),
+        it (element.contents.begin()),
+        lineBetween (false),
+        lineAfter (false),
+        textLength (0)
+        {}
+};
+
+int     Html::printElement (ostream &stream, const Element& element, Rendering* rendering)
 {
-    bool    lineBetween = false;
-    bool    lineAfter = false;
+    Allocs::Scope   scope (Allocs::render);
 
-    ElementContents::const_iterator   it;
+    vector< Printing >  stack (1, Printing (element));     // the elements being printed, the innermost last
 
-    int     textLength = 0;
+    string  indent;
 
     if (verbose)
     {
-        stream << indent << element.tag << endl;
+        stream << indent << Markup::name(element.tag) << endl;
 
         indent += "  ";
     }
 
-    for (it = element.contents.begin(); it != element.contents.end(); ++it)
+    for (;;)
     {
-        if (!it->text.empty())
+        Printing&       printing = stack.back();
+        const Element&  element = *printing.element;
+
+        const ElementContents::const_iterator   end = element.contents.end();
+
+        // print parts up to the next sub element to be printed
+
+        const Element*  next = 0;
+
+        while (next == 0 && printing.it != end)
         {
-            if (lineAfter || lineBetween)
-                stream << "\n\n";
+            const ElementPart&  part = *printing.it++;
 
-            if (!element.contentMask.empty())
-            {
-                stream << indent << element.contentMask;
-                textLength += element.contentMask.length();
-            }
-            else if (element.padWidth == 0)
+            if (!part.text.empty())
             {
-                stream << indent << it->text;
-                textLength += it->text.length();
-            }
-            else
-            {
-                // suppose a list has items of the form:
-                //     term - description
-                // would it not be nice to line up the descriptions ?
-
-                // line them up by padding the current text length to the pad width calculated earlier
+                if (printing.lineAfter || printing.lineBetween)
+                    stream << "\n\n";
 
-                size_t  pos = it->text.find(" - ");
+                if (rendering && element.tag == Markup::term)
+                {
+                    stream << indent;
 
-                if (pos == string::npos && it->text.substr(0,2) == "- ")
-                    pos = 0, --textLength;
+                    rendering->pieces.push_back(Rendering::Piece (Rendering::slot, stream.tellp(), part.text.length(), &element));
 
-                if (pos == string::npos)
+                    stream << part.text;
+                    printing.textLength += part.text.length();
+                }
+                else if (element.contentMask)
+                {
+                    stream << indent << *element.contentMask;
+                    printing.textLength += element.contentMask->length();
+                }
+                else if (element.padWidth == 0)
                 {
-                    stream << indent << it->text;
-                    textLength += it->text.length();
+                    stream << indent << part.text;
+                    printing.textLength += part.text.length();
                 }
                 else
                 {
-                    stream << it->text.substr(0, pos);
-                    textLength += pos;
+                    // suppose a list has items of the form:
+                    //     term - description
+                    // would it not be nice to line up the descriptions ?
+
+                    // line them up by padding the current text length to the pad width calculated earlier
+
+                    size_t  pos = part.text.find(" - ");
+
+                    if (pos == string::npos && part.text.substr(0,2) == "- ")
+                        pos = 0, --printing.textLength;
 
-                    while (textLength++ < element.padWidth)
-                        stream << indent << ' ';
+                    if (pos == string::npos)
+                    {
+                        stream << indent << part.text;
+                        printing.textLength += part.text.length();
+                    }
+                    else
+                    {
+                        stream << part.text.substr(0, pos);
+                        printing.textLength += pos;
 
-                    stream << it->text.substr(pos);
+                        if (rendering)
+                        {
+                            const int   padding = max(0, element.padWidth - printing.textLength);
+
+                            rendering->pieces.push_back(Rendering::Piece (Rendering::pad, stream.tellp(), padding, 0, element.padWidth, printing.textLength));
+                            rendering->padded = true;
+                        }
+
+                        while (printing.textLength++ < element.padWidth)
+                            stream << indent << ' ';
+
+                        stream << part.text.substr(pos);
+                    }
                 }
+
+                printing.lineAfter = false;
+                printing.lineBetween = part.subElement && part.subElement->lineBefore;
             }
 
-            lineAfter = false;
-            lineBetween = it->lineBeforeSubElement;
+            if (part.subElement == 0 || (part.subElement->tag == Markup::comment && !verbose))
+                continue;
+
+            next = part.subElement;
+
+            printing.lineBetween |= next->tag == Markup::pass;
+
+            if (printing.lineAfter || printing.lineBetween && next->lineBefore)
+                stream << "\n\n";
         }
 
-        if (it->subElement)
+        if (next)
         {
-            const Element&  subElement = *it->subElement;
+            // print the sub element before the rest of the parts
 
-            if (subElement.tag == Comment::beg && !verbose)
-                continue;
+            stack.push_back(Printing (*next));
 
-            lineBetween |= subElement.tag == Markup::pass;
+            if (rendering)
+                rendering->pieces.push_back(Rendering::Piece (Rendering::open, stream.tellp()));
 
-            if (lineAfter || lineBetween && it->lineBeforeSubElement)
-                stream << "\n\n";
+            if (verbose)
+            {
+                stream << indent << Markup::name(next->tag) << endl;
 
-            textLength += printElement(stream, subElement, indent);
+                indent += "  ";
+            }
 
-            if (subElement.extraNewLine && (it + 1 != element.contents.end()))
-                if (subElement.endOfSentence)
-                    stream << "\n\n";
-                else
-                    stream << "\n";
+            continue;
+        }
+
+        // the element is printed - resume the element that holds it
+
+        if (verbose)
+        {
+            string  endTag;
+
+            if (element.tag == Markup::comment)
+                endTag = Comment::end;
+            else
+                endTag.assign(Markup::name(element.tag)).insert(1, "/");
+
+            indent.erase(indent.length() - 2);
 
-            lineAfter = it->lineAfterSubElement;
-            lineBetween = element.tag == Markup::none;
+            stream << endl << indent << endTag << endl;
         }
-    }
 
-    if (verbose)
-    {
-        string  endTag;
+        const int   textLength = printing.textLength;
 
-        if (element.tag == Comment::beg)
-            endTag = Comment::end;
-        else
-            endTag.assign(element.tag).insert(1, "/");
+        stack.pop_back();
 
-        stream << endl << indent.substr(2) << endTag << endl;
-    }
+        if (stack.empty())
+            return (textLength);
+
+        if (rendering)
+            rendering->pieces.push_back(Rendering::Piece (Rendering::close, stream.tellp()));
+
+        Printing&       parent = stack.back();
+        const Element&  subElement = element;
+
+        parent.textLength += textLength;
 
-    return (textLength);
+        if (subElement.extraNewLine && (parent.it != parent.element->contents.end()))
+            if (subElement.endOfSentence)
+                stream << "\n\n";
+            else
+                stream << "\n";
+
+        parent.lineAfter = subElement.lineAfter;
+        parent.lineBetween = parent.element->tag == Markup::none;
+    }
 }
 
 //----------------------------------------------------------------------------//
 //
-// One minor task the parser performs while reading a cribsheet is to replace
-// html escape sequences with the special characters they represent.
+// A Rendering is printed by printElement() into its buffer with the pieces
+// that may change noted as it goes:  the text of each term (a slot), each
+// padding and where each sub element begins and ends.  The latter are only
+// needed for the padding and are dropped when there is none.
 //
-// The implementation gets the job done.  Other, possibly more efficient, ways
-// of doing this exist.
-//
-// Note the first time initialisation of the local (static) map.
+// Rendering::print() copies the buffer up to each piece and then the piece
+// itself, the contentMask in place of the text of a blanked term.  It keeps
+// the difference blanking makes to the text length of each element open so
+// that padding is adjusted just as printElement() would pad.
 //
 //----------------------------------------------------------------------------//
 
-string& Html::Escapes::replace (string& statement)
+//----  render an element, noting the pieces that may change
+
+Html::Rendering::Rendering (const Element& element) :
+    element (element),
+    padded (false)
 {
-    static  map< string, string, greater<string> >   escapes;
+    if (verbose)
+        return;
+
+    ostringstream   stream;
+
+    printElement(stream, element, this);
+
+    buffer = stream.str();
+
+    if (padded)
+        return;
+
+    vector< Piece >     slots;
+
+    for (vector< Piece >::const_iterator it = pieces.begin(); it != pieces.end(); ++it)
+        if (it->kind == slot)
+            slots.push_back(*it);
+
+    pieces.swap(slots);
+}
+
+//----  print the rendered element with its blanked terms
 
-    if (escapes.empty())
+void    Html::Rendering::print (ostream& stream) const
+{
+    if (verbose)
     {
-        escapes.insert(pair<string, string> ("&lt;",   "<"));
-        escapes.insert(pair<string, string> ("&gt;",   ">"));
-        escapes.insert(pair<string, string> ("&amp;",  "&"));
-        escapes.insert(pair<string, string> ("&apos;", "'"));
-        escapes.insert(pair<string, string> ("&quot;", "\""));
+        printElement(stream, element);
 
-        escapes.insert(pair<string, string> ("&#60;",   "<"));
-        escapes.insert(pair<string, string> ("&#62;",   ">"));
-        escapes.insert(pair<string, string> ("&#38;",  "&"));
-        escapes.insert(pair<string, string> ("&#39;", "'"));
-        escapes.insert(pair<string, string> ("&#34;", "\""));
+        return;
     }
 
-    if (statement.find("&") != string::npos &&
-        statement.find(";") != string::npos)
+    string  text;
+
+    text.reserve(buffer.length() + 4 * pieces.size());
+
+    vector< int >   adjust (1, 0);      // the difference in text length of each element open
+
+    size_t  from = 0;
+
+    for (vector< Piece >::const_iterator it = pieces.begin(); it != pieces.end(); ++it)
     {
-        map< string, string, greater<string> >::const_iterator   it;
+        const Piece&    piece = *it;
+
+        text.append(buffer, from, piece.begin - from);
 
-        for (it = escapes.begin(); it != escapes.end(); ++it)
+        from = piece.begin + piece.length;
+
+        switch (piece.kind)
         {
-            size_t  pos = string::npos;
+            case (slot):
+                if (piece.term->contentMask)
+                {
+                    text.append(*piece.term->contentMask);
 
-            while ((pos = statement.find(it->first)) != string::npos)
-                statement.replace(pos, it->first.size(), it->second);
+                    adjust.back() += int(piece.term->contentMask->length()) - int(piece.length);
+                }
+                else
+                {
+                    text.append(buffer, piece.begin, piece.length);
+                }
+                break;
+
+            case (pad):
+                {
+                    const int   textLength = piece.textLength + adjust.back();
+
+                    if (textLength < piece.width)
+                        text.append(piece.width - textLength, ' ');
+
+                    adjust.back() = max(textLength, piece.width) - max(piece.textLength, piece.width);
+                }
+                break;
+
+            case (open):
+                adjust.push_back(0);
+                break;
+
+            case (close):
+                {
+                    const int   inner = adjust.back();
+
+                    adjust.pop_back();
+
+                    adjust.back() += inner;
+                }
+                break;
         }
     }
 
-    return (statement);
+    text.append(buffer, from, string::npos);
+
+    stream.write(text.data(), text.length());
 }
 
 // EOF
@@ -35,42 +35,61 @@
 
 #include <deque>
 #include <string>
+#include <vector>
 
 using namespace std;
 
 //----------------------------------------------------------------------------//
 //
-// The Html::Markup and Html::Comment namespaces defines symbolic names for
-// the limited number of html tags recognised by the cribtutor program.
+// The Html::Markup namespace defines symbolic names for the limited number
+// of html tags recognised by the cribtutor program.
+//
+// An element's tag is a small integer, not a string, so testing the tag of
+// an element is an integer comparison.  The tags the program recognises have
+// the fixed values below.  Any other tag the parser meets is interned:  it is
+// given the next free value the first time it is seen.  Should the values run
+// out, every new tag is given the value unknown, which no recognised tag has.
+//
+// Two values do not correspond to an html tag.  Comments are elements with
+// the tag comment.  The Massage module renames <code> elements within <pre>
+// elements asisCode.
+//
+// Markup::name() yields the text of a tag, for printing the raw parse tree.
 //
 //----------------------------------------------------------------------------//
 
 namespace       Html
 {
-    namespace Markup
-    {
-        static string  none ("<>");
-        static string  hdr1 ("<h1>");
-        static string  hdr2 ("<h2>");
-        static string  hdr3 ("<h3>");
-        static string  para ("<p>");
-        static string  term ("<em>");
-        static string  asis ("<pre>");
-        static string  pass ("<div>");
-        static string  code ("<code>");
-        static string  span ("<span>");
-        static string  ulst ("<ul>");
-        static string  olst ("<ol>");
-        static string  item ("<li>");
-        static string  newl ("<br>");
-        static string  rule ("<hr>");
-        static string  link ("<a>");
-    };
+    typedef     unsigned short  Tag;
 
-    namespace Comment
+    namespace Markup
     {
-        static string  beg ("<!--");
-        static string  end ("-->");
+        enum
+        {
+            none,       // <>
+            hdr1,       // <h1>
+            hdr2,       // <h2>
+            hdr3,       // <h3>
+            para,       // <p>
+            term,       // <em>
+            asis,       // <pre>
+            pass,       // <div>
+            code,       // <code>
+            span,       // <span>
+            ulst,       // <ul>
+            olst,       // <ol>
+            item,       // <li>
+            newl,       // <br>
+            rule,       // <hr>
+            link,       // <a>
+            asisCode,   // <pre><code>
+            comment,    // <!--
+            known,      // the first interned tag
+            unknown = 0xffff    // every tag met once the values have run out
+        };
+
+        extern  Tag             intern (const string& name);
+        extern  const string&   name (Tag tag);
     };
 };
 
@@ -92,15 +111,19 @@ namespace       Html
 // The Element structure represents an html element with a tag and content.
 // The content is optional and is represented by a sequence of ElementParts.
 //
-// An element has a reference count used to prevent premature destruction
-// during STL copy operations.
+// Elements are allocated from the current Html::Arena (see Arena.h) and
+// belong to it:  the arena destroys them all when it is destroyed.  Nothing
+// else deletes an element.
 //
 // An element carries state set during the annotation of the parse tree.  All
 // but the contentMask do not change once set.  Of these, all but strictOrder
 // are only used by printElement().
 //
-// The contentMask is used by printElement() to blank out terms.  It is set
-// and reset by routines in the Dialogue namespace.
+// The contentMask is used by printElement() and by a Rendering (see below) to
+// blank out terms.  It is set and reset by routines in the Dialogue namespace.
+// It points to a mask held by the Terms namespace, not in the element, since
+// very few elements are ever blanked.  It is null when the element is not
+// blanked.
 //
 // The strictOrder flag enables the Dialogue namespace to distinguish terms
 // that must be entered in order relative to adjacent terms from terms in
@@ -108,7 +131,12 @@ namespace       Html
 // terms in the list.
 //
 // The other data members are flags that control when printElement() prints
-// new lines.  Essentially corner cases are turned into state.
+// new lines, before and after the element among others.  Essentially corner
+// cases are turned into state.
+//
+// A parse tree has an Element and an ElementPart for almost every tag in the
+// cribsheet so both are kept small:  the contents are held in a vector, which
+// costs nothing until something is added to it, and the flags are bit fields.
 //
 //----------------------------------------------------------------------------//
 
@@ -116,45 +144,39 @@ namespace       Html
 {
     struct      ElementPart;
 
-    typedef     deque< Html::ElementPart >  ElementContents;
+    typedef     vector< Html::ElementPart >     ElementContents;
 
     // a representation of an html element
 
     struct      Element
     {
-        const string    tag;
         ElementContents     contents;
+        const string*       contentMask;
 
-        int         referenceCount;
-        bool        strictOrder;
-        bool        endOfSentence;
-        bool        startOfSentence;
-        bool        extraNewLine;
-        int         padWidth;
-        string      contentMask;
+        Tag             tag;
+        unsigned short  padWidth;
 
-        Element (string tag = Html::Markup::none) :
+        bool            strictOrder : 1;
+        bool            endOfSentence : 1;
+        bool            startOfSentence : 1;
+        bool            extraNewLine : 1;
+        bool            lineBefore : 1;
+        bool            lineAfter : 1;
+
+        Element (Tag tag = Html::Markup::none) :
+            contentMask (0),
             tag (tag),
-            referenceCount (0),
+            padWidth (0),
             strictOrder (true),
             endOfSentence (false),
             startOfSentence (false),
             extraNewLine (false),
-            padWidth (0)
+            lineBefore (false),
+            lineAfter (false)
             {}
 
-        Element&    merge (Html::Element& rhs)
-        {
-            while (rhs.contents.size())
-            {
-                this->contents.push_back(rhs.contents.front());
-                rhs.contents.pop_front();
-            }
-
-            const_cast <string&> (rhs.tag) = Html::Markup::none;
-
-            return (*this);
-        }
+        static  void*   operator new (size_t size);
+        static  void    operator delete (void* element);
     };
 };
 
@@ -166,13 +188,10 @@ namespace       Html
 // The subelement is modelled by a pointer to an Element structure thus
 // modelling the nested html element structure by indirect recursion.
 //
-// ElementPart is provided with the four for use with STL containers:
-// default constructor, destructor, copy constructor and assignment operator.
-// The reference count in the subelement Element structure is used to ensure
-// destruction of subelement only when appropriate (not during STL copies).
-//
-// The other data members are flags that control when printElement() prints
-// new lines.  Essentially corner cases are turned into state.
+// A part does not own its subelement, the arena does, so a part may be copied,
+// moved, shuffled or discarded without regard to the subelement.  Copying a
+// part copies its text, however, so parts are rearranged with swap(), which
+// does not.
 //
 //----------------------------------------------------------------------------//
 
@@ -184,54 +203,74 @@ namespace       Html
     {
         string    text;
 
-        bool      lineBeforeSubElement;
-        bool      lineAfterSubElement;
-
         Element*  subElement;
 
         ElementPart (const string& text = "", Element* sub = 0) :
         text (text),
-        lineBeforeSubElement (false),
-        lineAfterSubElement (false),
         subElement (sub)
-        {
-            if (subElement)
-                subElement->referenceCount++;
-        }
+        {}
 
         ElementPart (Element* sub) :
-        lineBeforeSubElement (false),
-        lineAfterSubElement (false),
         subElement (sub)
-        {
-            if (subElement)
-                subElement->referenceCount++;
-        }
+        {}
 
-       ~ElementPart ()
+        void    swap (ElementPart& rhs)
         {
-            if (subElement && --subElement->referenceCount == 0)
-                delete subElement;
-        }
+            text.swap(rhs.text);
 
-        ElementPart (const ElementPart& rhs)
-        {
-            *this = rhs;
-        }
+            Element*    sub = subElement;
 
-        ElementPart &   operator= (const ElementPart& rhs)
-        {
-            text = rhs.text;
             subElement = rhs.subElement;
+            rhs.subElement = sub;
+        }
+    };
 
-            if (subElement)
-                subElement->referenceCount++;
+    //----  so that std algorithms such as random_shuffle() swap parts without copying them
 
-            lineBeforeSubElement = rhs.lineBeforeSubElement;
-            lineAfterSubElement = rhs.lineAfterSubElement;
+    inline  void    swap (ElementPart& lhs, ElementPart& rhs)
+    {
+        lhs.swap(rhs);
+    }
+};
 
-            return (*this);
-        }
+//----------------------------------------------------------------------------//
+//
+// A parse may publish the chapters of a cribsheet as it goes so that a quiz
+// may start on the first chapter while the rest are still being parsed (see
+// Loader.h).  The caller passes a Chapters structure that gives:
+//    - tag - the tag of the chapter headers (<h1> or <h2>)
+//    - publisher - the routine to call with each chapter, once it is parsed
+//    - stream - to pass to the publisher
+//
+// The chapters are the parts of the (block level) element that holds the
+// first chapter header.  The parts before that header are published as soon
+// as the header is seen, as are the parts from each header up to the next.
+// The parts from the last header are published once the parse is done.
+//
+// The parts are moved out of the element into a new Element (with no tag)
+// for publication so the parse tree ends up without them.  Nothing is
+// published, and the parse tree is whole, when there are no chapter headers.
+//
+//----------------------------------------------------------------------------//
+
+namespace       Html
+{
+    typedef void    (*Publisher) (void* stream, Element& chapter);
+
+    struct      Chapters
+    {
+        Tag         tag;
+        Publisher   publisher;
+        void*       stream;
+
+        Element*    element;    // that holds the chapters, once the first header is seen
+
+        Chapters (Publisher publisher = 0, void* stream = 0) :
+            tag (Markup::none),
+            publisher (publisher),
+            stream (stream),
+            element (0)
+            {}
     };
 };
 
@@ -239,29 +278,150 @@ namespace       Html
 //
 // There are but two interface routines, operator<< for the Element class and
 // Html::parseCribSheet().  The latter is passed:
-//    - input - file handle open at the beginning of the cribsheet file
+//    - input - the text of the cribsheet (usually a mapping of the file) or
+//      a stream open at the beginning of the cribsheet
 //    - element - is the empty top level Element for the new parse tree
+//    - chapters - optional, to publish the chapters as they are parsed
 //
 // The operator<< for the Element class may be used to print out any part of
 // parsed html cribsheet for debug purposes but its normal run time use is to
 // print statements (i.e. html paragraphs) with one or more terms blanked out.
 //
-// parseElement(), the html parser, is exposed for use by the Massage module,
-// which is part of the Html namespace.
-//
 // For implementation details see Html.cpp.
 //
 //----------------------------------------------------------------------------//
 
 namespace       Html
 {
-    extern  void    parseCribSheet (ifstream &input, Html::Element &element);
-
-    extern  void    parseElement (istream& input, Element &element);
+    extern  void    parseCribSheet (const char* text, size_t length, Html::Element &element, Chapters* chapters = 0);
+    extern  void    parseCribSheet (istream &input, Html::Element &element, Chapters* chapters = 0);
 
     extern  bool    verbose;    // debug only
 
     extern  ostream&    operator<< (ostream &stream, const Element& element);
 };
 
+//----------------------------------------------------------------------------//
+//
+// A statement is printed once for each attempt to fill in its blanks and
+// only its blanked terms change from one attempt to the next.  A Rendering
+// prints the statement once, when it is constructed, into a buffer and notes
+// where the text of each term (<em>) is.  Printing the Rendering copies the
+// buffer with the contentMask of each blanked term in place of its text and
+// writes the copy in one go.  The parse tree is not walked again.
+//
+// Blanking a term changes the length of the text before the padding that
+// lines up the descriptions of list items so the padding is noted too, along
+// with where each element begins and ends, and adjusted as the buffer is
+// copied.
+//
+// A Rendering follows changes to the contentMask of the terms of the element
+// but no others.  A verbose print is not rendered in advance.
+//
+//----------------------------------------------------------------------------//
+
+namespace       Html
+{
+    class   Rendering;
+
+    extern  int     printElement (ostream &stream, const Element& element, Rendering* rendering);
+
+    class   Rendering
+    {
+    public:
+        explicit Rendering (const Element& element);
+
+    public:
+        void    print (ostream& stream) const;
+
+    private:
+        Rendering (const Rendering&);               // not implemented
+        Rendering& operator= (const Rendering&);    // not implemented
+
+        friend  int     printElement (ostream &stream, const Element& element, Rendering* rendering);
+
+    private:
+        enum    Kind
+        {
+            slot, pad, open, close
+        };
+
+        struct  Piece
+        {
+            Kind            kind;
+            size_t          begin;      // in the buffer
+            size_t          length;     // of the term text or the padding in the buffer
+
+            const Element*  term;       // that may be blanked (slot)
+
+            int             width;      // to pad to (pad)
+            int             textLength; // before the padding (pad)
+
+            Piece (Kind kind, size_t begin, size_t length = 0, const Element* term = 0, int width = 0, int textLength = 0) :
+                kind (kind),
+                begin (begin),
+                length (length),
+                term (term),
+                width (width),
+                textLength (textLength)
+                {}
+        };
+
+        const Element&  element;
+
+        string          buffer;
+        vector< Piece > pieces;
+        bool            padded;
+    };
+
+    inline  ostream&    operator<< (ostream &stream, const Rendering& rendering)
+    {
+        return (rendering.print(stream), stream);
+    }
+};
+
+//----------------------------------------------------------------------------//
+//
+// The Builder class lets a reader of some other mark-up build a parse tree
+// just as the html parser would (see Markdown.h).  The reader calls, in the
+// order of the document:
+//    - text() - to add text to the element last opened
+//    - open() and close() - either side of the contents of an element
+//    - comment() - to add an html comment
+// and then finish() to end the parse tree.  The builder massages and annotates
+// the parse tree as it is built so the tree is the same as that of the html
+// parser given the equivalent html.
+//
+//----------------------------------------------------------------------------//
+
+namespace       Html
+{
+    struct  Context;
+
+    class   Builder
+    {
+    public:
+        explicit Builder (Element& element, Chapters* chapters = 0);
+        ~Builder ();
+
+    public:
+        void    text (const char* text, size_t length);
+        void    text (const string& text)   { this->text(text.data(), text.length()); }
+
+        void    open (const Tag tag);
+        void    close (void);
+
+        void    comment (const string& text);
+
+        void    finish (void);
+
+    private:
+        Builder (const Builder&);
+        Builder&    operator= (const Builder&);
+
+        deque< Context* >   contexts;   // of the elements open, the top level first
+        string              content;    // the text added since the last element
+    };
+};
+
 # endif  /* _HTML_H */
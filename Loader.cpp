@@ -0,0 +1,292 @@
+//----------------------------------------------------------------------------//
+//
+// Implementation file for the Loader class of the cribtutor program.
+//
+// The Loader class parses the cribsheets in the list on a pool of threads
+// while the program consumes the parse trees one at a time, in list order.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include "Loader.h"
+#include "Lock.h"
+
+#include <cstdlib>
+
+using namespace std;
+
+//----------------------------------------------------------------------------//
+//
+// See Loader.h for a description of the class interface.
+//
+// Each cribsheet has a Sheet that holds the parse tree, the arena it is built
+// in and the state of the parse.  The mutex protects the state of every sheet,
+// the index of the next sheet to parse and the index of the sheet the consumer
+// waits for.  The parsed condition is signalled each time a parse is complete
+// and the room condition each time the consumer moves on or the threads must
+// stop.  When the loader streams, the parsed condition is also signalled each
+// time a chapter is published.
+//
+// The threads take sheets in list order so the sheet the consumer waits for
+// is always being parsed or already parsed.
+//
+// The quiz ends the program with exit() when the user quits.  The threads
+// must not be left running while static objects are destroyed so an exit
+// handler stops them.  The handler is registered before the threads start.
+//
+//----------------------------------------------------------------------------//
+
+struct  Loader::Sheet
+{
+    Loader&         loader;
+    string          pathName;
+
+    Html::Arena     arena;      // must outlive the parse tree
+    Html::Element   html;
+
+    Html::Chapters              chapters;
+    deque< Html::Element* >     published;  // but not yet taken by the consumer
+
+    bool            found;
+    bool            done;
+
+    Sheet (Loader& loader, const string& pathName) :
+        loader (loader),
+        pathName (pathName),
+        chapters (Loader::publish, this),
+        found (false),
+        done (false)
+        {}
+};
+
+namespace
+{
+    Loader*     active = 0;     // the loader stopped by the exit handler
+};
+
+//----  start the threads
+
+Loader::Loader (const deque< string >& pathNames, Reader reader, int threadCount, size_t lookahead, bool stream) :
+    reader (reader),
+    lookahead (lookahead),
+    stream (stream),
+    next (0),
+    consumer (0),
+    stopping (false)
+{
+    pthread_mutex_init(&mutex, 0);
+    pthread_cond_init(&parsed, 0);
+    pthread_cond_init(&room, 0);
+
+    for (size_t ii = 0; ii < pathNames.size(); ++ii)
+        sheets.push_back(new Sheet (*this, pathNames[ii]));
+
+    if ((size_t) threadCount > sheets.size())
+        threadCount = sheets.size();
+
+    static  bool    registered = false;
+
+    if (!registered)
+        registered = (atexit(stopAtExit) == 0);
+
+    active = this;
+
+    for (int ii = 0; ii < threadCount; ++ii)
+    {
+        pthread_t   thread;
+
+        if (pthread_create(&thread, 0, work, this) == 0)
+            threads.push_back(thread);
+    }
+}
+
+//----  stop the threads and release the remaining parse trees
+
+Loader::~Loader ()
+{
+    stop();
+
+    for (size_t ii = 0; ii < sheets.size(); ++ii)
+        delete sheets[ii];
+
+    if (active == this)
+        active = 0;
+
+    pthread_cond_destroy(&room);
+    pthread_cond_destroy(&parsed);
+    pthread_mutex_destroy(&mutex);
+}
+
+//----  wait for the next chapter of a cribsheet to be published and take it
+
+Html::Element*  Loader::chapter (size_t index)
+{
+    Sheet&  sheet = *sheets[index];
+
+    if (threads.empty() && !sheet.done)
+        parse(sheet);
+
+    Lock    lock (mutex);
+
+    consumer = index;
+
+    pthread_cond_broadcast(&room);
+
+    while (sheet.published.empty() && !sheet.done)
+        pthread_cond_wait(&parsed, &mutex);
+
+    if (sheet.published.empty())
+        return (0);
+
+    Html::Element*  chapter = sheet.published.front();
+
+    sheet.published.pop_front();
+
+    return (chapter);
+}
+
+//----  wait for a cribsheet to be parsed and return its parse tree
+
+Html::Element*  Loader::wait (size_t index)
+{
+    Sheet&  sheet = *sheets[index];
+
+    if (threads.empty())
+    {
+        if (!sheet.done)
+            parse(sheet);
+
+        return (sheet.found ? &sheet.html : 0);
+    }
+
+    Lock    lock (mutex);
+
+    consumer = index;
+
+    pthread_cond_broadcast(&room);
+
+    while (!sheet.done)
+        pthread_cond_wait(&parsed, &mutex);
+
+    return (sheet.found ? &sheet.html : 0);
+}
+
+//----  return the arena of a cribsheet's parse tree
+
+Html::Arena&    Loader::arena (size_t index)
+{
+    return (sheets[index]->arena);
+}
+
+//----  release the parse tree of a cribsheet
+
+void    Loader::release (size_t index)
+{
+    if (!threads.empty())
+    {
+        Lock    lock (mutex);
+
+        while (!sheets[index]->done)
+            pthread_cond_wait(&parsed, &mutex);
+    }
+
+    delete sheets[index];
+
+    sheets[index] = 0;
+}
+
+//----  the thread routine:  parse cribsheets until there are no more
+
+void*   Loader::work (void* parameter)
+{
+    Loader&     loader = * (Loader *) parameter;
+
+    for (;;)
+    {
+        Sheet*  sheet;
+
+        {
+            Lock    lock (loader.mutex);
+
+            while (!loader.stopping && loader.next < loader.sheets.size() && loader.next > loader.consumer + loader.lookahead)
+                pthread_cond_wait(&loader.room, &loader.mutex);
+
+            if (loader.stopping || loader.next == loader.sheets.size())
+                break;
+
+            sheet = loader.sheets[loader.next++];
+        }
+
+        loader.parse(*sheet);
+    }
+
+    return (0);
+}
+
+//----  parse a cribsheet in its own arena
+
+void    Loader::parse (Sheet& sheet)
+{
+    bool    found;
+
+    {
+        Html::Arena::Scope  scope (sheet.arena);
+
+        found = reader(sheet.pathName, sheet.html, stream ? &sheet.chapters : 0);
+    }
+
+    Lock    lock (mutex);
+
+    sheet.found = found;
+    sheet.done = true;
+
+    pthread_cond_broadcast(&parsed);
+}
+
+//----  the publisher:  pass a chapter on to the consumer
+
+void    Loader::publish (void* parameter, Html::Element& chapter)
+{
+    Sheet&  sheet = * (Sheet *) parameter;
+
+    Lock    lock (sheet.loader.mutex);
+
+    sheet.published.push_back(&chapter);
+
+    pthread_cond_broadcast(&sheet.loader.parsed);
+}
+
+//----  stop the threads once they have finished what they are doing
+
+void    Loader::stop (void)
+{
+    {
+        Lock    lock (mutex);
+
+        stopping = true;
+
+        pthread_cond_broadcast(&room);
+    }
+
+    for (size_t ii = 0; ii < threads.size(); ++ii)
+        pthread_join(threads[ii], 0);
+
+    threads.clear();
+}
+
+//----  the exit handler
+
+void    Loader::stopAtExit (void)
+{
+    if (active)
+        active->stop();
+}
+
+// EOF
@@ -0,0 +1,135 @@
+# ifndef    _LOADER_H
+# define    _LOADER_H
+
+//----------------------------------------------------------------------------//
+//
+// Interface file for the Loader class of the cribtutor program.
+//
+// The cribtutor program processes the cribsheets in its list one at a time:
+// it parses a cribsheet and then runs the quiz on it (or prints it) before
+// going on to the next.
+//
+// Parsing one cribsheet does not depend on any other.  The Loader class
+// parses the cribsheets in the list on a pool of threads while the program
+// consumes the parse trees one at a time, in list order.  The threads may
+// be kept just a few cribsheets ahead of the consumer.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include "Arena.h"
+#include "Html.h"
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+
+using namespace std;
+
+//----------------------------------------------------------------------------//
+//
+// A Loader is given the list of cribsheet path names, the routine that reads
+// and parses a cribsheet, the number of threads to use and how far ahead of
+// the consumer they may go.  The threads start at once and take cribsheets
+// in list order.  They parse the cribsheet the consumer waits for, or is
+// using, and at most lookahead cribsheets after it.
+//
+// The parse tree of each cribsheet is built in an arena of its own.  The
+// consumer of a parse tree should make that arena current while it uses it:
+//
+//      Loader  loader (pathNames, readCribSheet, threads, lookahead);
+//
+//      for (size_t ii = 0; ii < pathNames.size(); ++ii)
+//      {
+//          Html::Element*  html = loader.wait(ii);
+//
+//          Html::Arena::Scope  scope (loader.arena(ii));
+//          ...
+//          loader.release(ii);
+//      }
+//
+// wait() returns 0 when the reader returned false (the cribsheet was not
+// found).  release() destroys the parse tree and its arena.
+//
+// When no thread can be started, wait() parses the cribsheet itself.
+//
+// A loader may also stream each cribsheet, a chapter at a time, so that the
+// consumer need not wait for the whole of a large cribsheet to be parsed.
+// The reader is then passed a Chapters structure (see Html.h) and sets its
+// tag.  The consumer takes the chapters in turn before it waits:
+//
+//      while ((chapter = loader.chapter(ii)) != 0)
+//          ...
+//
+//      Html::Element*  html = loader.wait(ii);
+//
+// chapter() returns 0 once the parse is done and every chapter has been
+// taken.  When none were published the parse tree is whole.  Otherwise all
+// its chapters have been moved out of it.  A consumer that streams should
+// not make the arena current:  the thread may still be adding to it.
+//
+// release() waits for the parse to finish.
+//
+// The destructor waits for the threads to finish what they are doing and
+// releases whatever has not been released.  The threads are stopped in the
+// same way should the program exit before the loader is destroyed.
+//
+//----------------------------------------------------------------------------//
+
+class   Loader
+{
+public:
+    typedef bool    (*Reader) (const string& pathName, Html::Element& html, Html::Chapters* chapters);
+
+public:
+    Loader (const deque< string >& pathNames, Reader reader, int threads, size_t lookahead, bool stream = false);
+   ~Loader ();
+
+public:
+    Html::Element*  chapter (size_t index);
+    Html::Element*  wait (size_t index);
+    Html::Arena&    arena (size_t index);
+    void            release (size_t index);
+
+private:
+    struct  Sheet;
+
+    static  void*   work (void* loader);
+    static  void    publish (void* sheet, Html::Element& chapter);
+    static  void    stopAtExit (void);
+
+    void    parse (Sheet& sheet);
+
+    void    stop (void);
+
+private:
+    Loader (const Loader&);                 // not implemented
+    Loader& operator= (const Loader&);      // not implemented
+
+private:
+    Reader              reader;
+
+    vector< Sheet* >    sheets;
+    vector< pthread_t > threads;
+
+    size_t              lookahead;
+    bool                stream;
+    size_t              next;
+    size_t              consumer;
+    bool                stopping;
+
+    pthread_mutex_t     mutex;
+    pthread_cond_t      parsed;
+    pthread_cond_t      room;
+};
+
+# endif  /* _LOADER_H */
@@ -0,0 +1,55 @@
+# ifndef    _LOCK_H
+# define    _LOCK_H
+
+//----------------------------------------------------------------------------//
+//
+// Interface file for the Lock class of the cribtutor program.
+//
+// The cribtutor program may parse several cribsheets at once, each in a
+// thread of its own.  The little data the threads share is protected by
+// POSIX mutexes.
+//
+// The Lock class is a scope guard that holds a mutex while it exists.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include <pthread.h>
+
+//----------------------------------------------------------------------------//
+//
+// Shared data is protected by a plain pthread_mutex_t with a static
+// initialiser, not by an object with a destructor, so that the mutex is
+// still usable by threads that are running while the program exits:
+//
+//      static  pthread_mutex_t     mutex = PTHREAD_MUTEX_INITIALIZER;
+//      ...
+//      {
+//          Lock    lock (mutex);
+//          ...
+//      }
+//
+//----------------------------------------------------------------------------//
+
+class   Lock
+{
+public:
+    explicit Lock (pthread_mutex_t& mutex) : mutex (mutex)  { pthread_mutex_lock(&mutex); }
+   ~Lock ()                                                 { pthread_mutex_unlock(&mutex); }
+
+private:
+    Lock (const Lock&);                 // not implemented
+    Lock& operator= (const Lock&);      // not implemented
+
+private:
+    pthread_mutex_t&    mutex;
+};
+
+# endif  /* _LOCK_H */
@@ -0,0 +1,105 @@
+//----------------------------------------------------------------------------//
+//
+// Implementation file for the MappedFile class of the cribtutor program.
+//
+// The MappedFile class maps a cribsheet file into memory and presents the
+// mapped bytes as a stream buffer so the parser can read from them directly.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include "MappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+//----------------------------------------------------------------------------//
+//
+// See MappedFile.h for a description of the class interface and behaviour.
+//
+// Only regular files are mapped.  Anything else is not even opened because
+// the caller will open it again and a pipe does not survive being opened
+// twice.  The file descriptor is closed as soon as the mapping exists:  the
+// mapping keeps its own reference to the file.
+//
+// The whole of the mapping is the get area of the stream buffer.  The stream
+// never needs to underflow() so the default implementation (which reports end
+// of file) suffices.  putback() of the character just read only moves the get
+// pointer so the read only mapping is never written.
+//
+// An empty file cannot be mapped but is still 'mapped':  it has no content.
+//
+//----------------------------------------------------------------------------//
+
+//----  map the file into memory
+
+MappedFile::MappedFile (const string& pathName) :
+    isMapped (false),
+    address (0),
+    length (0)
+{
+    setg(0, 0, 0);
+
+    // do not open a pipe:  opening it twice would lose what is written to it
+
+    struct stat     status;
+
+    if (stat(pathName.c_str(), &status) != 0 || !S_ISREG(status.st_mode))
+        return;
+
+    const int   fd = open(pathName.c_str(), O_RDONLY);
+
+    if (fd < 0)
+        return;
+
+    if (fstat(fd, &status) == 0 && S_ISREG(status.st_mode))
+    {
+        length = status.st_size;
+
+        if (length == 0)
+        {
+            isMapped = true;
+        }
+        else
+        {
+            void*   mapping = mmap(0, length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (mapping != MAP_FAILED)
+            {
+                address = (char *) mapping;
+                isMapped = true;
+
+                madvise(mapping, length, MADV_SEQUENTIAL);
+            }
+            else
+            {
+                length = 0;
+            }
+        }
+    }
+
+    close(fd);
+
+    setg(address, address, address + length);
+}
+
+//----  release the mapping
+
+MappedFile::~MappedFile ()
+{
+    if (address)
+        munmap(address, length);
+}
+
+// EOF
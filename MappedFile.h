@@ -0,0 +1,73 @@
+# ifndef    _MAPPEDFILE_H
+# define    _MAPPEDFILE_H
+
+//----------------------------------------------------------------------------//
+//
+// Interface file for the MappedFile class of the cribtutor program.
+//
+// The cribtutor program reads cribsheets from files.  Originally each was
+// read through an ifstream, which copies the file into its own buffer before
+// the parser copies it again into strings.
+//
+// The MappedFile class maps a cribsheet file into memory and presents the
+// mapped bytes as a stream buffer.  The parser reads directly from the
+// mapping:  there is no intermediate file buffer.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include <streambuf>
+#include <string>
+
+using namespace std;
+
+//----------------------------------------------------------------------------//
+//
+// A MappedFile is a read only stream buffer.  Use it with an istream:
+//
+//      MappedFile  sheet (pathName);
+//
+//      if (sheet.mapped())
+//      {
+//          istream     input (&sheet);
+//          ...
+//      }
+//
+// Not every file can be mapped.  Pipes, terminals and other special files
+// cannot.  mapped() returns false when the file could not be opened or could
+// not be mapped and the caller is expected to fall back to an ifstream.
+//
+// The mapping is released when the object is destroyed.
+//
+//----------------------------------------------------------------------------//
+
+class   MappedFile : public streambuf
+{
+public:
+    explicit MappedFile (const string& pathName);
+    ~MappedFile ();
+
+public:
+    bool    mapped (void) const         { return (isMapped); }
+
+    const char*     data (void) const   { return (address); }
+    size_t          size (void) const   { return (length); }
+
+private:
+    MappedFile (const MappedFile&);             // not implemented
+    MappedFile& operator= (const MappedFile&);  // not implemented
+
+private:
+    bool    isMapped;
+    char*   address;
+    size_t  length;
+};
+
+# endif  /* _MAPPEDFILE_H */
@@ -0,0 +1,1078 @@
+//----------------------------------------------------------------------------//
+//
+// Implementation file for the Markdown reader of the cribtutor program.
+//
+// The reader builds the parse tree of a Markdown cribsheet directly, through
+// an Html::Builder, with no html translation in between.
+//
+// See also Markdown.h.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include "Allocs.h"
+#include "Markdown.h"
+
+#include <cctype>
+#include <cstring>
+
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------//
+//
+// See Markdown.h for a description of the interface.
+//
+// The reader splits the cribsheet into lines and makes a single pass over
+// them, block by block.  Each block is passed to the builder as soon as its
+// last line is known.  Only a list is looked over twice:  once to find where
+// it and its items end and whether it is loose, once to pass it on.  A list is
+// loose when a blank line separates its items or the blocks within an item.
+// The items of a loose list hold paragraphs, those of a tight list hold text.
+//
+// The blocks within a list item or block quote are read by recursion on the
+// lines of the item or quote, with the list marker, indent or > removed.
+// A Line is a pointer pair into the cribsheet so this copies no text.
+//
+// The text of a paragraph or heading is read by a second recursive routine
+// that finds the emphasis, code spans, links and comments within it.
+//
+// The reader reproduces the layout of pandoc's html, down to the new lines
+// between blocks, so that the parse tree is the same.
+//
+//----------------------------------------------------------------------------//
+
+namespace       Html
+{
+    namespace   Markdown
+    {
+        struct  Line
+        {
+            const char*     begin;
+            const char*     end;
+        };
+
+        typedef vector< Line >  Lines;
+
+        // routines that read blocks
+
+        static  void    readLines (const char* text, size_t length, Lines& lines);
+        static  void    readBlocks (Builder& builder, const Lines& lines, const bool tight, const bool item);
+
+        static  size_t  readComment (Builder& builder, const Lines& lines, size_t index);
+        static  size_t  readIndentedCode (Builder& builder, const Lines& lines, size_t index);
+        static  size_t  readFencedCode (Builder& builder, const Lines& lines, size_t index);
+        static  size_t  readQuote (Builder& builder, const Lines& lines, size_t index);
+        static  size_t  readList (Builder& builder, const Lines& lines, size_t index);
+        static  size_t  readParagraph (Builder& builder, const Lines& lines, size_t index, const bool tight, const bool item);
+
+        static  void    readHeading (Builder& builder, const Line& line, size_t level);
+
+        // routines that read text
+
+        static  void    readText (Builder& builder, const char* begin, const char* end);
+
+        static  const char*     readCodeSpan (Builder& builder, string& text, const char* cursor, const char* end);
+        static  const char*     readComment (Builder& builder, string& text, const char* cursor, const char* end);
+        static  const char*     readEmphasis (Builder& builder, string& text, const char* begin, const char* cursor, const char* end);
+        static  const char*     readLink (Builder& builder, string& text, const char* cursor, const char* end);
+
+        // simple routines that recognise blocks
+
+        inline  bool    blank (const Line& line);
+        inline  size_t  indent (const Line& line);
+        inline  const char*     dedent (const Line& line, size_t columns);
+
+        inline  size_t  headingLevel (const Line& line);
+        inline  bool    thematicBreak (const Line& line);
+        inline  size_t  fence (const Line& line, char& fenceChar);
+        inline  bool    listMarker (const Line& line, char& kind, size_t& width, const char** content = 0);
+
+        // simple routines for text
+
+        inline  const char*     find (const char* begin, const char* end, const char* text);
+        inline  string&     escape (string& text, const char* begin, const char* end);
+        inline  void    flush (Builder& builder, string& text);
+    };
+};
+
+//----------------------------------------------------------------------------//
+//
+// The external routines of the Markdown reader.
+//
+//----------------------------------------------------------------------------//
+
+void    Html::Markdown::parseCribSheet (const char* text, size_t length, Element &element, Chapters* chapters)
+{
+    Allocs::Scope   scope (Allocs::parse);
+
+    Lines       lines;
+
+    readLines(text, length, lines);
+
+    Builder     builder (element, chapters);
+
+    readBlocks(builder, lines, false, false);
+
+    builder.finish();
+}
+
+void    Html::Markdown::parseCribSheet (istream &input, Element &element, Chapters* chapters)
+{
+    Allocs::Scope   scope (Allocs::parse);
+
+    ostringstream   buffer;
+
+    buffer << input.rdbuf();
+
+    const string    text (buffer.str());
+
+    Markdown::parseCribSheet(text.data(), text.length(), element, chapters);
+}
+
+//----------------------------------------------------------------------------//
+//
+// Routines that read blocks.
+//
+// Each routine for a block is passed the index of its first line and returns
+// the index of the line after it.
+//
+// At the top level, and in block quotes, a new line follows each block, save
+// code blocks, ordered lists and comments, just as pandoc's html has them.
+// Within a list item, a new line separates the blocks.
+//
+//----------------------------------------------------------------------------//
+
+//----  split the cribsheet into lines
+
+void    Html::Markdown::readLines (const char* text, size_t length, Lines& lines)
+{
+    const char*     end = text + length;
+
+    while (text < end)
+    {
+        const char*     next = (const char *) memchr(text, '\n', end - text);
+
+        Line    line = { text, next ? next : end };
+
+        if (line.end > line.begin && line.end[-1] == '\r')
+            --line.end;
+
+        lines.push_back(line);
+
+        text = next ? next + 1 : end;
+    }
+}
+
+//----  read a sequence of blocks
+
+void    Html::Markdown::readBlocks (Builder& builder, const Lines& lines, const bool tight, const bool item)
+{
+    size_t  index = 0;
+
+    bool    first = true;
+
+    while (index < lines.size())
+    {
+        const Line&     line = lines[index];
+
+        if (blank(line))
+        {
+            ++index;
+
+            continue;
+        }
+
+        if (item && !first)
+            builder.text("\n");
+
+        first = false;
+
+        bool    newLine = !item;
+
+        char    kind;
+        size_t  width;
+        size_t  level;
+
+        if (indent(line) >= 4)
+        {
+            index = readIndentedCode(builder, lines, index);
+
+            newLine = false;
+        }
+        else if (fence(line, kind))
+        {
+            index = readFencedCode(builder, lines, index);
+
+            newLine = false;
+        }
+        else if ((level = headingLevel(line)) != 0)
+        {
+            readHeading(builder, line, level);
+
+            ++index;
+        }
+        else if (thematicBreak(line))
+        {
+            builder.open(Markup::rule);
+            builder.close();
+
+            ++index;
+        }
+        else if (*dedent(line, 3) == '>')
+        {
+            static  const Tag   quote = Markup::intern("<blockquote>");
+
+            builder.open(quote);
+            builder.text("\n");
+
+            index = readQuote(builder, lines, index);
+
+            builder.close();
+        }
+        else if (listMarker(line, kind, width))
+        {
+            newLine = newLine && (kind == '-' || kind == '+' || kind == '*');
+
+            index = readList(builder, lines, index);
+        }
+        else
+        {
+            const size_t    next = readComment(builder, lines, index);
+
+            if (next != index)
+            {
+                index = next;
+
+                newLine = false;
+            }
+            else
+            {
+                index = readParagraph(builder, lines, index, tight, item);
+            }
+        }
+
+        if (newLine)
+            builder.text("\n");
+    }
+}
+
+//----  read a comment on lines of its own, if it is followed by a blank line
+
+size_t  Html::Markdown::readComment (Builder& builder, const Lines& lines, size_t index)
+{
+    const char*     begin = dedent(lines[index], 3);
+
+    if ((size_t) (lines[index].end - begin) < 4 || memcmp(begin, "<!--", 4) != 0)
+        return (index);
+
+    begin += 4;
+
+    for (size_t last = index; last < lines.size(); ++last)
+    {
+        const Line&     line = lines[last];
+
+        const char*     start = last == index ? begin : line.begin;
+        const char*     close = find(start, line.end, "-->");
+
+        if (close == 0)
+            continue;
+
+        Line    rest = { close + 3, line.end };
+
+        if (!blank(rest) || (last + 1 < lines.size() && !blank(lines[last + 1])))
+            return (index);
+
+        string  comment (begin, index == last ? close : lines[index].end);
+
+        for (size_t ii = index + 1; ii <= last; ++ii)
+        {
+            comment += '\n';
+            comment.append(lines[ii].begin, ii == last ? close : lines[ii].end);
+        }
+
+        builder.comment(comment);
+
+        return (last + 1);
+    }
+
+    return (index);
+}
+
+//----  read a code block indented by four spaces
+
+size_t  Html::Markdown::readIndentedCode (Builder& builder, const Lines& lines, size_t index)
+{
+    size_t  last = index;
+
+    for (size_t ii = index; ii < lines.size() && (blank(lines[ii]) || indent(lines[ii]) >= 4); ++ii)
+        if (!blank(lines[ii]))
+            last = ii;
+
+    string  code;
+
+    for (size_t ii = index; ii <= last; ++ii)
+    {
+        if (ii != index)
+            code += '\n';
+
+        escape(code, dedent(lines[ii], 4), lines[ii].end);
+    }
+
+    builder.open(Markup::asis);
+    builder.open(Markup::code);
+    builder.text(code);
+    builder.close();
+    builder.close();
+
+    return (last + 1);
+}
+
+//----  read a code block between fences
+
+size_t  Html::Markdown::readFencedCode (Builder& builder, const Lines& lines, size_t index)
+{
+    char    fenceChar = 0;
+
+    const size_t    length = fence(lines[index], fenceChar);
+    const size_t    offset = indent(lines[index]);
+
+    string  code;
+
+    size_t  ii;
+
+    for (ii = index + 1; ii < lines.size(); ++ii)
+    {
+        char    closeChar = 0;
+
+        const size_t    closeLength = fence(lines[ii], closeChar);
+
+        if (closeLength >= length && closeChar == fenceChar)
+        {
+            const char*     after = dedent(lines[ii], 3) + closeLength;
+
+            Line    rest = { after, lines[ii].end };
+
+            if (blank(rest))
+                break;
+        }
+
+        if (ii != index + 1)
+            code += '\n';
+
+        escape(code, dedent(lines[ii], offset), lines[ii].end);
+    }
+
+    builder.open(Markup::asis);
+    builder.open(Markup::code);
+    builder.text(code);
+    builder.close();
+    builder.close();
+
+    return (ii < lines.size() ? ii + 1 : ii);
+}
+
+//----  read a block quote
+
+size_t  Html::Markdown::readQuote (Builder& builder, const Lines& lines, size_t index)
+{
+    Lines   quote;
+
+    size_t  ii;
+
+    for (ii = index; ii < lines.size() && !blank(lines[ii]); ++ii)
+    {
+        Line    line = lines[ii];
+
+        const char*     marker = dedent(line, 3);
+
+        if (*marker == '>')
+        {
+            line.begin = marker + 1;
+
+            if (line.begin < line.end && *line.begin == ' ')
+                ++line.begin;
+        }
+
+        quote.push_back(line);
+    }
+
+    readBlocks(builder, quote, false, false);
+
+    return (ii);
+}
+
+//----  read a list:  find where each item ends and whether the list is loose, then read the items
+
+size_t  Html::Markdown::readList (Builder& builder, const Lines& lines, size_t index)
+{
+    char    kind;
+    size_t  width;
+
+    listMarker(lines[index], kind, width);
+
+    vector< size_t >    items;          // the first line of each item
+    vector< size_t >    widths;         // the indent of the lines of each item
+
+    bool    loose = false;
+
+    size_t  end = index;                // the line after the last of the list
+
+    for (size_t ii = index; ii < lines.size(); )
+    {
+        char    nextKind;
+        size_t  nextWidth;
+
+        if (ii == index || (listMarker(lines[ii], nextKind, nextWidth) && nextKind == kind && indent(lines[ii]) < width))
+        {
+            if (ii != index)
+                listMarker(lines[ii], kind, width);
+
+            items.push_back(ii);
+            widths.push_back(width);
+
+            end = ++ii;
+
+            continue;
+        }
+
+        if (blank(lines[ii]))
+        {
+            size_t  next = ii;
+
+            while (next < lines.size() && blank(lines[next]))
+                ++next;
+
+            if (next == lines.size())
+                break;
+
+            const bool  marker = listMarker(lines[next], nextKind, nextWidth);
+
+            if (indent(lines[next]) >= width)
+            {
+                if (!marker)
+                    loose = true;
+            }
+            else if (marker && nextKind == kind)
+            {
+                loose = true;
+            }
+            else
+            {
+                break;
+            }
+
+            ii = next;
+
+            continue;
+        }
+
+        if (indent(lines[ii]) < width && listMarker(lines[ii], nextKind, nextWidth))
+            break;
+
+        if (indent(lines[ii]) < width && blank(lines[ii - 1]))
+            break;
+
+        end = ++ii;                     // indented or a lazy continuation
+    }
+
+    const bool  ordered = (kind == '.' || kind == ')');
+
+    builder.open(ordered ? Markup::olst : Markup::ulst);
+    builder.text("\n");
+
+    for (size_t nn = 0; nn < items.size(); ++nn)
+    {
+        const size_t    last = nn + 1 < items.size() ? items[nn + 1] : end;
+
+        Lines   item;
+
+        Line    line = lines[items[nn]];
+
+        listMarker(line, kind, width, &line.begin);
+
+        item.push_back(line);
+
+        for (size_t ii = items[nn] + 1; ii < last; ++ii)
+        {
+            line = lines[ii];
+
+            line.begin = dedent(line, widths[nn]);
+
+            item.push_back(line);
+        }
+
+        builder.open(Markup::item);
+
+        readBlocks(builder, item, !loose, true);
+
+        builder.close();
+        builder.text("\n");
+    }
+
+    builder.close();
+
+    return (end);
+}
+
+//----  read a paragraph:  lines of text up to a blank line (or a list within a list item)
+
+size_t  Html::Markdown::readParagraph (Builder& builder, const Lines& lines, size_t index, const bool tight, const bool item)
+{
+    string  text;
+
+    size_t  ii;
+
+    for (ii = index; ii < lines.size() && !blank(lines[ii]); ++ii)
+    {
+        char    kind;
+        size_t  width;
+
+        if (item && ii != index && listMarker(lines[ii], kind, width))
+            break;
+
+        if (ii != index)
+            text += '\n';
+
+        text.append(dedent(lines[ii], string::npos), lines[ii].end);
+    }
+
+    size_t  length = text.find_last_not_of(" \t");
+
+    text.erase(length == string::npos ? 0 : length + 1);
+
+    if (!tight)
+        builder.open(Markup::para);
+
+    readText(builder, text.data(), text.data() + text.length());
+
+    if (!tight)
+        builder.close();
+
+    return (ii);
+}
+
+//----  read a heading
+
+void    Html::Markdown::readHeading (Builder& builder, const Line& line, size_t level)
+{
+    static  const char*     headings[] = { "<h1>", "<h2>", "<h3>", "<h4>", "<h5>", "<h6>" };
+
+    const char*     begin = dedent(line, 3) + level;
+    const char*     end = line.end;
+
+    while (begin < end && isspace((unsigned char) *begin))
+        ++begin;
+
+    while (end > begin && isspace((unsigned char) end[-1]))
+        --end;
+
+    // drop the closing sequence of #s
+
+    const char*     close = end;
+
+    while (close > begin && close[-1] == '#')
+        --close;
+
+    if (close == begin || isspace((unsigned char) close[-1]))
+        for (end = close; end > begin && isspace((unsigned char) end[-1]); --end)
+            ;
+
+    builder.open(Markup::intern(headings[level - 1]));
+
+    readText(builder, begin, end);
+
+    builder.close();
+}
+
+//----------------------------------------------------------------------------//
+//
+// Routines that read text.
+//
+// readText() copies text to the builder up to the next character that may
+// start something else.  Each routine for something else is passed the text
+// not yet copied, which it copies before it opens an element, and returns
+// the position after the something else or 0 if it turns out to be text.
+//
+// Emphasis follows a simplified form of the CommonMark rules:  a run of * or
+// _ opens emphasis if a character other than white space follows it and is
+// closed by the next run of the same length that follows such a character.
+// An _ does not open or close emphasis within a word.
+//
+// Text within code spans and code blocks is escaped, as pandoc's is, so that
+// the character references the builder replaces are those of the Markdown.
+//
+//----------------------------------------------------------------------------//
+
+//----  read the text of a paragraph or heading
+
+void    Html::Markdown::readText (Builder& builder, const char* begin, const char* end)
+{
+    static  const char  special[] = "\\`<*_[";
+
+    string  text;
+
+    const char*     cursor = begin;
+
+    while (cursor < end)
+    {
+        const char*     next = cursor;
+
+        while (next < end && strchr(special, *next) == 0)
+            ++next;
+
+        text.append(cursor, next);
+
+        if ((cursor = next) == end)
+            break;
+
+        const char*     after = 0;
+
+        switch (*cursor)
+        {
+          case '\\':
+            if (cursor + 1 < end && ispunct((unsigned char) cursor[1]))
+            {
+                text += cursor[1];
+
+                after = cursor + 2;
+            }
+            break;
+
+          case '`':
+            after = readCodeSpan(builder, text, cursor, end);
+            break;
+
+          case '<':
+            after = readComment(builder, text, cursor, end);
+            break;
+
+          case '*':
+          case '_':
+            after = readEmphasis(builder, text, begin, cursor, end);
+            break;
+
+          case '[':
+            after = readLink(builder, text, cursor, end);
+            break;
+        }
+
+        if (after == 0)
+        {
+            // not special after all:  take the whole run of the character as text
+
+            const char*     run = cursor;
+
+            while (run < end && *run == *cursor)
+                ++run;
+
+            text.append(cursor, run);
+
+            after = run;
+        }
+
+        cursor = after;
+    }
+
+    flush(builder, text);
+}
+
+//----  read a code span
+
+const char*     Html::Markdown::readCodeSpan (Builder& builder, string& text, const char* cursor, const char* end)
+{
+    const char*     begin = cursor;
+
+    while (begin < end && *begin == '`')
+        ++begin;
+
+    const size_t    length = begin - cursor;
+
+    for (const char* close = begin; close < end; )
+    {
+        if (*close != '`')
+        {
+            ++close;
+
+            continue;
+        }
+
+        const char*     after = close;
+
+        while (after < end && *after == '`')
+            ++after;
+
+        if ((size_t) (after - close) == length)
+        {
+            const char*     first = begin;
+            const char*     last = close;
+
+            if (last - first >= 2 && *first == ' ' && last[-1] == ' ')
+                ++first, --last;
+
+            string  code;
+
+            escape(code, first, last);
+
+            for (size_t pos = code.find('\n'); pos != string::npos; pos = code.find('\n', pos))
+                code[pos] = ' ';
+
+            flush(builder, text);
+
+            builder.open(Markup::code);
+            builder.text(code);
+            builder.close();
+
+            return (after);
+        }
+
+        close = after;
+    }
+
+    return (0);
+}
+
+//----  read a comment
+
+const char*     Html::Markdown::readComment (Builder& builder, string& text, const char* cursor, const char* end)
+{
+    if (end - cursor < 4 || memcmp(cursor, "<!--", 4) != 0)
+        return (0);
+
+    const char*     close = find(cursor + 4, end, "-->");
+
+    if (close == 0)
+        return (0);
+
+    flush(builder, text);
+
+    builder.comment(string (cursor + 4, close));
+
+    return (close + 3);
+}
+
+//----  read emphasis or strong emphasis
+
+const char*     Html::Markdown::readEmphasis (Builder& builder, string& text, const char* begin, const char* cursor, const char* end)
+{
+    static  const Tag   strong = Markup::intern("<strong>");
+
+    const char  delimiter = *cursor;
+
+    const char*     inner = cursor;
+
+    while (inner < end && *inner == delimiter)
+        ++inner;
+
+    const size_t    length = inner - cursor;
+
+    if (length > 3 || inner == end || isspace((unsigned char) *inner))
+        return (0);
+
+    if (delimiter == '_' && cursor > begin && isalnum((unsigned char) cursor[-1]))
+        return (0);
+
+    for (const char* close = inner; close < end; )
+    {
+        if (*close == '\\')
+        {
+            close += 2;
+
+            continue;
+        }
+
+        if (*close != delimiter)
+        {
+            ++close;
+
+            continue;
+        }
+
+        const char*     after = close;
+
+        while (after < end && *after == delimiter)
+            ++after;
+
+        const bool  closes = !isspace((unsigned char) close[-1]) && (delimiter != '_' || after == end || !isalnum((unsigned char) *after));
+
+        if (closes && (size_t) (after - close) == length)
+        {
+            flush(builder, text);
+
+            if (length != 1)
+                builder.open(strong);
+
+            if (length != 2)
+                builder.open(Markup::term);
+
+            readText(builder, inner, close);
+
+            if (length != 1)
+                builder.close();
+
+            if (length != 2)
+                builder.close();
+
+            return (after);
+        }
+
+        close = after;
+    }
+
+    return (0);
+}
+
+//----  read a link - only its text is of interest
+
+const char*     Html::Markdown::readLink (Builder& builder, string& text, const char* cursor, const char* end)
+{
+    int     depth = 0;
+
+    const char*     close;
+
+    for (close = cursor; close < end; ++close)
+    {
+        if (*close == '\\')
+            ++close;
+        else if (*close == '[')
+            ++depth;
+        else if (*close == ']' && --depth == 0)
+            break;
+    }
+
+    if (close >= end || close + 1 == end || close[1] != '(')
+        return (0);
+
+    const char*     after = (const char *) memchr(close, ')', end - close);
+
+    if (after == 0)
+        return (0);
+
+    flush(builder, text);
+
+    builder.open(Markup::link);
+
+    readText(builder, cursor + 1, close);
+
+    builder.close();
+
+    return (after + 1);
+}
+
+//----------------------------------------------------------------------------//
+//
+// Simple routines that recognise blocks.
+//
+// Indents are measured in columns:  a tab moves on to the next multiple of four.
+//
+//----------------------------------------------------------------------------//
+
+//----  Is the line blank ?
+
+bool    Html::Markdown::blank (const Line& line)
+{
+    for (const char* cursor = line.begin; cursor < line.end; ++cursor)
+        if (!isspace((unsigned char) *cursor))
+            return (false);
+
+    return (true);
+}
+
+//----  How far is the line indented ?
+
+size_t  Html::Markdown::indent (const Line& line)
+{
+    size_t  columns = 0;
+
+    for (const char* cursor = line.begin; cursor < line.end; ++cursor)
+        if (*cursor == ' ')
+            ++columns;
+        else if (*cursor == '\t')
+            columns = (columns / 4 + 1) * 4;
+        else
+            break;
+
+    return (columns);
+}
+
+//----  Where does the line start, less up to so many columns of indent ?
+
+const char*     Html::Markdown::dedent (const Line& line, size_t columns)
+{
+    size_t  column = 0;
+
+    const char*     cursor;
+
+    for (cursor = line.begin; cursor < line.end && column < columns; ++cursor)
+        if (*cursor == ' ')
+            ++column;
+        else if (*cursor == '\t')
+            column = (column / 4 + 1) * 4;
+        else
+            break;
+
+    return (cursor);
+}
+
+//----  Is the line an ATX heading and, if so, of what level ?
+
+size_t  Html::Markdown::headingLevel (const Line& line)
+{
+    const char*     cursor = dedent(line, 3);
+
+    size_t  level = 0;
+
+    while (cursor < line.end && *cursor == '#')
+        ++cursor, ++level;
+
+    if (level == 0 || level > 6 || (cursor < line.end && !isspace((unsigned char) *cursor)))
+        return (0);
+
+    return (level);
+}
+
+//----  Is the line a thematic break ?
+
+bool    Html::Markdown::thematicBreak (const Line& line)
+{
+    const char*     cursor = dedent(line, 3);
+
+    if (cursor == line.end || strchr("-*_", *cursor) == 0)
+        return (false);
+
+    const char  mark = *cursor;
+
+    size_t  count = 0;
+
+    for (; cursor < line.end; ++cursor)
+        if (*cursor == mark)
+            ++count;
+        else if (!isspace((unsigned char) *cursor))
+            return (false);
+
+    return (count >= 3);
+}
+
+//----  Is the line a code fence and, if so, how long is it ?
+
+size_t  Html::Markdown::fence (const Line& line, char& fenceChar)
+{
+    const char*     cursor = dedent(line, 3);
+
+    if (cursor == line.end || (*cursor != '`' && *cursor != '~'))
+        return (0);
+
+    fenceChar = *cursor;
+
+    const char*     after = cursor;
+
+    while (after < line.end && *after == fenceChar)
+        ++after;
+
+    if (after - cursor < 3)
+        return (0);
+
+    if (fenceChar == '`' && memchr(after, '`', line.end - after) != 0)
+        return (0);
+
+    return (after - cursor);
+}
+
+//----  Does the line start a list item ?  If so, of what kind, with what indent and where does its content start ?
+
+bool    Html::Markdown::listMarker (const Line& line, char& kind, size_t& width, const char** content)
+{
+    const char*     cursor = dedent(line, 3);
+    const char*     marker = cursor;
+
+    if (cursor < line.end && strchr("-+*", *cursor) != 0)
+    {
+        kind = *cursor++;
+    }
+    else
+    {
+        while (cursor < line.end && isdigit((unsigned char) *cursor) && cursor - marker < 9)
+            ++cursor;
+
+        if (cursor == marker || cursor == line.end || (*cursor != '.' && *cursor != ')'))
+            return (false);
+
+        kind = *cursor++;
+    }
+
+    if (cursor < line.end && *cursor != ' ' && *cursor != '\t')
+        return (false);
+
+    Line    rest = { cursor, line.end };
+
+    if (thematicBreak(line) && strchr("-*", kind) != 0)
+        return (false);
+
+    size_t  spaces = indent(rest);
+
+    if (blank(rest) || spaces > 4)
+        spaces = 1;
+
+    width = indent(line) + (cursor - marker) + spaces;
+
+    if (content)
+        *content = blank(rest) ? line.end : dedent(rest, spaces);
+
+    return (true);
+}
+
+//----------------------------------------------------------------------------//
+//
+// Simple routines for text.
+//
+//----------------------------------------------------------------------------//
+
+//----  find text within a range
+
+const char*     Html::Markdown::find (const char* begin, const char* end, const char* text)
+{
+    const size_t    length = strlen(text);
+
+    for (const char* cursor = begin; end - cursor >= (ptrdiff_t) length; ++cursor)
+        if (memcmp(cursor, text, length) == 0)
+            return (cursor);
+
+    return (0);
+}
+
+//----  append text with the characters special to html escaped
+
+string&     Html::Markdown::escape (string& text, const char* begin, const char* end)
+{
+    for (const char* cursor = begin; cursor < end; ++cursor)
+        switch (*cursor)
+        {
+          case '&':   text += "&amp;";    break;
+          case '<':   text += "&lt;";     break;
+          case '>':   text += "&gt;";     break;
+          default:    text += *cursor;    break;
+        }
+
+    return (text);
+}
+
+//----  pass the text read so far to the builder
+
+void    Html::Markdown::flush (Builder& builder, string& text)
+{
+    if (!text.empty())
+        builder.text(text);
+
+    text.clear();
+}
+
+// EOF
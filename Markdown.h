@@ -0,0 +1,74 @@
+# ifndef    _MARKDOWN_H
+# define    _MARKDOWN_H
+
+//----------------------------------------------------------------------------//
+//
+// Interface file for the Markdown reader of the cribtutor program.
+//
+// Cribsheet authors write in Markdown more often than in html.  They used to
+// translate each cribsheet with pandoc and list the html in cribsheets.txt.
+// The Massage module (see Massage.h) then undoes those parts of the pandoc
+// layout that do not suit the program.
+//
+// The Markdown reader removes the translation step:  a cribsheet whose name
+// ends in .md is read as Markdown and the parse tree is built directly from
+// it, with no html in between.
+//
+// The reader handles the subset of CommonMark that cribsheets use:
+//    - paragraphs, ATX headings (# to ######) and thematic breaks
+//    - bullet (+, - and *) and ordered (1. and 1)) lists, nested by indent
+//    - fenced (``` and ~~~) and indented code blocks
+//    - block quotes
+//    - *emphasis*, _emphasis_, **strong** and __strong__ emphasis
+//    - `code spans`, [links](url) and backslash escapes
+//    - html comments, both on lines of their own and within text
+// Other html is taken as text.
+//
+// As with pandoc, only a blank line ends a paragraph, except that a list may
+// follow the text of a list item directly.  A comment on a line of its own is
+// a block of its own when a blank line follows it.  Otherwise it is part of
+// the paragraph so that it may stop the paragraph being merged with a list.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include "Html.h"
+
+#include <iostream>
+
+using namespace std;
+
+//----------------------------------------------------------------------------//
+//
+// Html::Markdown::parseCribSheet() is the counterpart of Html::parseCribSheet()
+// for Markdown.  It is passed:
+//    - input - the text of the cribsheet (usually a mapping of the file) or
+//      a stream open at the beginning of the cribsheet
+//    - element - is the empty top level Element for the new parse tree
+//    - chapters - optional, to publish the chapters as they are parsed
+//
+// The parse tree is the one the html parser would build from pandoc's html so
+// the program treats the two alike:  see help/markdown.html for how lists,
+// code blocks and Shuffle List comments are massaged.
+//
+// For implementation details see Markdown.cpp.
+//
+//----------------------------------------------------------------------------//
+
+namespace       Html
+{
+    namespace   Markdown
+    {
+        extern  void    parseCribSheet (const char* text, size_t length, Html::Element &element, Chapters* chapters = 0);
+        extern  void    parseCribSheet (istream &input, Html::Element &element, Chapters* chapters = 0);
+    };
+};
+
+# endif  /* _MARKDOWN_H */
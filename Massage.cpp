@@ -2,16 +2,16 @@
 //
 // Implementation file for the Massage module of the cribtutor program.
 //
-// The intermediary pass of the cribtutor parser permits the parse tree to be
-// massaged.  This may be necessary when the cribsheet's html structure does
-// not conform to expectations.
+// The cribtutor parser permits the parse tree to be massaged.  This may be
+// necessary when the cribsheet's html structure does not conform to
+// expectations.
 //
 // This may arise from the use of html editors or of wiki mark-up with a
 // translator.
 //
-// The purpose of using a separate pass and a separate module is to provide
-// a space where necessary adaptations can be implemented without threatening
-// the integrity rest of the program.
+// The purpose of using a separate module is to provide a space where
+// necessary adaptations can be implemented without threatening the integrity
+// rest of the program.
 //
 // See also Massage.h.
 //
@@ -26,8 +26,6 @@
 //----------------------------------------------------------------------------//
 
 #include "Massage.h"
-#include <iostream>
-#include <sstream>
 
 using namespace std;
 
@@ -41,52 +39,12 @@ using namespace std;
 // generated by the pandoc translator from Markdown wiki mark-up, specifically,
 // that used on GitHub.
 //
-//----------------------------------------------------------------------------//
-
-namespace   Html
-{
-    typedef ElementContents::iterator   ContentsIterator;
-
-    namespace   Markdown
-    {
-        void    massageAsisLists (Element& element);
-        void    massageCodeElements (Element& parent);
-
-        void    fixupListShuffles (Element& listElement);
-        void    fixupCodeSpans (Element& parent);
-
-        // helper routines
-
-        bool    termsInCodeSpan (string &text, const char delim);
-    };
-};
-
-//----------------------------------------------------------------------------//
-//
-// Two helper routines to test:
-// - whether an element start with a given subelement
-// - whether an element ends with a given subelement
-//
-//----------------------------------------------------------------------------//
-
-namespace       Html
-{
-    bool    startsWithSubElement (const Element* element, const string& tag);
-    bool    endsWithSubElement (const Element* element, const string& tag);
-};
-
-//----------------------------------------------------------------------------//
-//
-// Massage the parse tree as required - the second pass of the parse operation.
+// The massage was once a pass over the whole parse tree.  It is now applied
+// by the parser as each element opens and closes (see Html.cpp) so these
+// routines only decide.  The parser makes the changes.
 //
 //----------------------------------------------------------------------------//
 
-void    Html::massageElement (Element& element)
-{
-    Markdown::massageAsisLists (element);
-    Markdown::massageCodeElements (element);
-}
-
 //----------------------------------------------------------------------------//
 //
 // The cribtutor program expects lists and asis blocks to be enclosed within
@@ -97,95 +55,39 @@ void    Html::massageElement (Element& element)
 // possible in Markdown to mark-up so that translators, such as pandoc, will
 // generate lists and asis blocks within paragraphs.
 //
-// The massageLists() routine compensates by:
+// The parser compensates by:
 //
 //   - enclosing list and asis elements in a (new) paragraph
 //   - merging the paragraphs either side with the new paragraph
 //   - unless they end/start with a comment
 //
+// This only applies to lists and asis blocks that are not already within
+// a paragraph, list or asis block.
+//
 // This massaging yields the expected cribtutor form by default while allowing
 // the merging to be turned off explicitly when required.
 //
-// This routine is processes ordered lists and is an appropriate place to call
-// fixupListShuffles.
-//
 //----------------------------------------------------------------------------//
 
-void    Html::Markdown::massageAsisLists (Element& element)
-{
-    ElementContents::iterator  it;
-
-    for (it = element.contents.begin(); it != element.contents.end(); ++it)
-    {
-        Element*    subElement = it->subElement;
-
-        if (subElement == 0)
-            continue;
-
-        const string&   tag = subElement->tag;
-
-        if (subElement->tag != Markup::asis)
-            if (subElement->tag != Markup::ulst && subElement->tag != Markup::olst)
-            {
-                if (subElement->tag != Markup::para)
-                    massageAsisLists (*subElement);
-                continue;
-            }
+//----  is the element a list or asis block that needs a paragraph of its own ?
 
-        if (subElement->tag == Markup::olst)
-            fixupListShuffles (*subElement);
-
-        // push the list down into a paragraph of its own
-
-        Element*  newParagraph = (Element *) new Element (Markup::para);
-
-        subElement->startOfSentence = true;
-
-        newParagraph->contents.push_back(ElementPart (subElement));
-
-        it->subElement = newParagraph;
-
-        // is there a paragraph after that does not start with a comment ?
-
-        if ((it + 1) != element.contents.end())
-        {
-            Element*    after = (it + 1)->subElement;
-
-            if (!startsWithSubElement(after, Comment::beg))
-            {
-                if (tag == Markup::ulst)
-                    after->contents.begin()->text.insert(0," ");
-
-                newParagraph->merge(*after);
-
-                int     index = it - element.contents.begin();
-
-                element.contents.erase(it + 1);
-
-                it = element.contents.begin() + index;
-            }
-        }
-
-        // is there a paragraph before that does not end with a comment ?
-
-        if (it != element.contents.begin())
-        {
-            Element*    before = (it - 1)->subElement;
-
-            if (!endsWithSubElement(before, Comment::beg))
-            {
-                newParagraph->contents.begin()->text += " ";
+bool    Html::Markdown::wrapInParagraph (const Tag tag)
+{
+    return (tag == Markup::asis || tag == Markup::ulst || tag == Markup::olst);
+}
 
-                before->merge(*newParagraph);
+//----  may a list be merged with the paragraph before, which ends with the given sub element ?
 
-                int     index = it - element.contents.begin() - 1;
+bool    Html::Markdown::mergeWithList (const Element* lastSubElement)
+{
+    return (!lastSubElement || lastSubElement->tag != Markup::comment);
+}
 
-                element.contents.erase(it);
+//----  may the paragraph after a list be merged, given its first part ?
 
-                it = element.contents.begin() + index;
-            }
-        }
-    }
+bool    Html::Markdown::mergeWithParagraph (const string& firstText, const Element* firstSubElement)
+{
+    return (!firstSubElement || firstSubElement->tag != Markup::comment || !firstText.empty());
 }
 
 //----------------------------------------------------------------------------//
@@ -197,32 +99,27 @@ void    Html::Markdown::massageAsisLists (Element& element)
 // Html::tidyText() only knows about one tag, not two.
 //
 // The minimal disruption principle say not to change the calling sequence to
-// Html::tidyText().  So, instead, this routine alters the <code> tag by
-// concatenation to <pre><code> and Html::tidyText() is able to act on this
-// to restore the indent in a safe and isolated manner.
+// Html::tidyText().  So, instead, the parser renames the <code> tag to the
+// pseudo tag <pre><code> (Markup::asisCode) and Html::tidyText() is able to
+// act on this to restore the indent in a safe and isolated manner.
 //
-// This routine is recursive, so by calling FixupCodeSpans() this fixup is
-// propagated throughout the parse tree.
+// Only a <code> element that opens its <pre> element is renamed.  No <code>
+// element within a <pre> element is treated as a code span (see below).
 //
 //----------------------------------------------------------------------------//
 
-void    Html::Markdown::massageCodeElements (Element& parent)
-{
-    for (ContentsIterator it = parent.contents.begin(); it != parent.contents.end(); ++it)
-    {
-        if (it->subElement == 0)
-            continue;
+//----  is the element the code of a code block ?
 
-        Html::Element&    element = *it->subElement;
+bool    Html::Markdown::codeBlock (const Tag parentTag, const Tag tag)
+{
+    return (tag == Markup::code && parentTag == Markup::asis);
+}
 
-        if (element.tag != Markup::code || parent.tag != Markup::asis)
-            massageCodeElements(element);
-        else if (it == parent.contents.begin() && it->text.empty())
-            const_cast <string&> (element.tag) = Markup::asis + Markup::code;
-    }
+//----  should the code block be renamed <pre><code> ?
 
-    if (parent.tag == Markup::code && !parent.contents.empty())
-        fixupCodeSpans(parent);
+bool    Html::Markdown::renameCodeBlock (const bool firstPart, const string& text)
+{
+    return (firstPart && text.empty());
 }
 
 //----------------------------------------------------------------------------//
@@ -232,8 +129,8 @@ void    Html::Markdown::massageCodeElements (Element& parent)
 // the <ol> tag and the first <li> tag.
 //
 // There is no way to get this when generating html from Markdown mark-up so
-// cribtutor accepts an alternative.  This alternative is massaged into the
-// desired form by this routine.
+// cribtutor accepts an alternative.  The parser massages this alternative
+// into the desired form when it opens the first part of the first list item.
 //
 // The Markdown syntax:
 /*
@@ -248,7 +145,7 @@ void    Html::Markdown::massageCodeElements (Element& parent)
        <li>Second list item.</li>
        </ol>
 */
-// which this routine massages into:
+// which the parser massages into:
 /*
        <ol><!-- Shuffle List -->
        <li> First list item.</li>
@@ -256,39 +153,16 @@ void    Html::Markdown::massageCodeElements (Element& parent)
        </ol>
  */
 //
+// Only ordered lists that the parser would enclose in a paragraph of their
+// own are massaged.
+//
 //----------------------------------------------------------------------------//
 
-void    Html::Markdown::fixupListShuffles (Element& listElement)
-{
-    Element*    subElement;
-
-    // is there a Shuffle List comment at the start of the first list item ?
+//----  is the comment text a Shuffle List comment ?
 
-    subElement = listElement.contents.front().subElement;
-
-    if (!subElement || subElement->tag != Markup::item) return;
-
-    Element&    itemElement = *subElement;
-
-    if (itemElement.contents.empty()) return;
-
-    subElement = itemElement.contents.front().subElement;
-
-    if (!subElement || subElement->tag != Comment::beg) return;
-
-    Element&    comment = *subElement;
-
-    if (comment.contents.empty()) return;
-
-    string& text = comment.contents.front().text;
-
-    if (text.find("Shuffle List") == string::npos) return;
-
-    // massage: move the comment from the first list item to the front of the list
-
-    listElement.contents.push_front(itemElement.contents.front());
-
-    itemElement.contents.pop_front();
+bool    Html::Markdown::shuffleComment (const string& text)
+{
+    return (text.find("Shuffle List") != string::npos);
 }
 
 //----------------------------------------------------------------------------//
@@ -297,41 +171,14 @@ void    Html::Markdown::fixupListShuffles (Element& listElement)
 // also renders apostrophe (tick) and grave (back tick) characters allowing
 // for the quoting of words or phrases of significance without blanking them.
 //
-// Markdown converts back ticks to <code> elements.  This routine reverses
-// this for inline (but not block) <code> elements.
+// Markdown converts back ticks to <code> elements.  The parser reverses this
+// for inline (but not block) <code> elements:  it quotes their text in back
+// ticks as it annotates it.
 //
 // It also 'recognises' and 'converts' blankable terms within code spans as,
 // some translators do not translate Markdown within code spans as they should.
 //
-// Markdown has support for nested back ticks.  This routine does not.
-//
-//----------------------------------------------------------------------------//
-
-void    Html::Markdown::fixupCodeSpans (Element& parent)
-{
-    if (parent.contents.size() == 1 && parent.contents.begin()->subElement == 0)
-    {
-        string& text = parent.contents.begin()->text;
-
-        if (termsInCodeSpan(text, '_') + termsInCodeSpan(text, '*'))
-        {
-            istringstream   codeSpan (text);
-
-            parent.contents.pop_front();
-
-            parseElement(codeSpan, parent);
-        }
-    }
-
-    parent.contents.begin()->text.insert(0,"`");
-
-    if (parent.contents.rbegin()->subElement)
-        parent.contents.push_back(ElementPart());
-
-    parent.contents.rbegin()->text.append("`");
-}
-
-//----------------------------------------------------------------------------//
+// Markdown has support for nested back ticks.  The parser does not.
 //
 // There seems to be no good reason why a term that merits Markdown back tick
 // emphasis should not also be blankable.
@@ -339,89 +186,80 @@ void    Html::Markdown::fixupCodeSpans (Element& parent)
 // Markdown mark-up within back tick code spans should be honored.  GitHub
 // appears to honour it but pandoc does not.  Cribtutor must compenstate.
 //
-// This routine converts code span text from Markdown syntax to html and
-// return true if any conversion took place.  It is expected the caller will
-// then parse the html.
+// This routine finds the Markdown emphasis in code span text and returns
+// true if there is any.  It is expected the caller will then add the terms
+// to the code span as it splits the text.
+//
+// The positions of the opening and closing delimiters of each term are put
+// in delimiters, in order.  Each kind of emphasis is found separately.  A term
+// of one kind that overlaps a term of the other is not a term.  Its delimiters
+// are left as text.
 //
 //----------------------------------------------------------------------------//
 
-bool    Html::Markdown::termsInCodeSpan (string &text, const char delim)
+namespace   Html
 {
-    bool    trueIfFound = false;
-
-    size_t  bpos = text.find(delim);
-    size_t  epos = string::npos;
-
-    do
+    namespace   Markdown
     {
-        if (bpos == string::npos)
-            break;
-
-        epos = text.find(delim,bpos + 1);
-
-        if (epos == string::npos)
-            break;
-
-        if (epos == bpos + 1 || text[epos + 1] == delim)
-            continue;
-
-        text.replace(epos,1,"</em>");
-        text.replace(bpos,1,"<em>");
+        static  void    termsInCodeSpan (const string& text, const char delim, vector< size_t >& delimiters);
+    };
+};
 
-        trueIfFound = true;
-    }
-    while (bpos = text.find_first_of(delim,epos + 1));
+//----  find both kinds of emphasis
 
-    return (trueIfFound);
-}
+bool    Html::Markdown::termsInCodeSpan (const string& text, vector< size_t >& delimiters)
+{
+    delimiters.clear();
 
-//----------------------------------------------------------------------------//
-//
-// Two helper routines to test:
-// - whether an element start with a given subelement
-// - whether an element ends with a given subelement
-//
-//----------------------------------------------------------------------------//
+    if (text.find_first_of("_*") == string::npos)
+        return (false);
 
-// test whether an element start with a given subelement
+    vector< size_t >    underscores, asterisks;
 
-bool    Html::startsWithSubElement (const Element* element, const string& tag)
-{
-    if (!element || element->tag != Markup::para)
-        return (true);
+    termsInCodeSpan(text, '_', underscores);
+    termsInCodeSpan(text, '*', asterisks);
 
-    size_t    parts = element->contents.size();
+    size_t  uu = 0, aa = 0;
 
-    if (parts == 0)
-        return (false);
+    while (uu < underscores.size() || aa < asterisks.size())
+    {
+        vector< size_t >&   terms = aa == asterisks.size() || (uu < underscores.size() && underscores[uu] < asterisks[aa]) ? underscores : asterisks;
+        size_t&             tt = &terms == &underscores ? uu : aa;
 
-    const ElementPart&    firstPart = element->contents[0];
+        const size_t    bpos = terms[tt++];
+        const size_t    epos = terms[tt++];
 
-    if (firstPart.subElement && firstPart.subElement->tag == tag)
-        if (firstPart.text.empty())
-            return (true);
+        if (delimiters.empty() || bpos > delimiters.back())
+        {
+            delimiters.push_back(bpos);
+            delimiters.push_back(epos);
+        }
+    }
 
-    return (false);
+    return (!delimiters.empty());
 }
 
-// test whether an element ends with a given subelement
+//----  find one kind of emphasis
 
-bool    Html::endsWithSubElement (const Element* element, const string& tag)
+void    Html::Markdown::termsInCodeSpan (const string& text, const char delim, vector< size_t >& delimiters)
 {
-    if (!element || element->tag != Markup::para)
-        return (true);
-
-    size_t    parts = element->contents.size();
+    size_t  bpos = text.find(delim);
 
-    if (parts == 0)
-        return (false);
+    while (bpos != string::npos)
+    {
+        const size_t    epos = text.find(delim, bpos + 1);
 
-    const ElementPart&    lastPart = element->contents[parts - 1];
+        if (epos == string::npos)
+            break;
 
-    if (lastPart.subElement && lastPart.subElement->tag == tag)
-        return (true);
+        if (epos != bpos + 1 && (epos + 1 == text.length() || text[epos + 1] != delim))
+        {
+            delimiters.push_back(bpos);
+            delimiters.push_back(epos);
+        }
 
-    return (false);
+        bpos = text.find(delim, epos + 1);
+    }
 }
 
 // EOF
@@ -24,13 +24,18 @@
 // how such an approach would help reduce the effort needed to solve problems
 // of a similar nature in the future.
 //
-// The solution chosen is an intermediary pass in the html parser between
+// The solution chosen was an intermediary pass in the html parser between
 // reading and parsing the html cribsheet and annotating the parse tree.
-// The intermediary pass may alter the parse in whatever way is necessary.
+// The intermediary pass could alter the parse in whatever way was necessary.
 //
-// The Message module encapsulates this intermediary pass.  Code to massage
-// the parse tree is to be added here rather than adapting code elsewhere to
-// handle 'exceptions' it was not designed to handle.
+// The three passes have since been fused into one (see Html.cpp) so the
+// massage is no longer a pass but a set of rules the parser applies as each
+// element opens and closes.  The rules still alter the parse tree in ways
+// the rest of the program was not designed to handle.
+//
+// The Message module encapsulates these rules.  Code to massage the parse
+// tree is to be added here rather than adapting code elsewhere to handle
+// 'exceptions' it was not designed to handle.
 //
 //----------------------------------------------------------------------------//
 
@@ -48,9 +53,22 @@ using namespace std;
 
 //----------------------------------------------------------------------------//
 //
-// The massage module extends the Html namespace.  It provides a single entry
-// point whereby extensions may be added with minimal disruption to the rest
-// of the program.
+// The massage module extends the Html namespace with the nested namespace
+// Markdown.  Its rules are questions the parser asks of the parse so far:
+//
+//    - wrapInParagraph() - is the element a list or code block that should
+//      be wrapped in a paragraph of its own ?
+//    - mergeWithList() - may the list be merged with the paragraph before,
+//      given the sub element of the paragraph's last part (0 for none) ?
+//    - mergeWithParagraph() - may the paragraph after the list be merged,
+//      given the text and sub element of its first part ?
+//    - codeBlock() - is the element the code of a code block ?  If not, a
+//      code element is a code span, unless it is within a code block
+//    - renameCodeBlock() - should the code block be renamed, given whether
+//      it opens the first part of its pre element and the text before it ?
+//    - shuffleComment() - is the comment text a Shuffle List comment ?
+//    - termsInCodeSpan() - finds the Markdown emphasis in the text of a code
+//      span and returns true if there is any
 //
 // See Massage.cpp for further details.
 //
@@ -58,7 +76,20 @@ using namespace std;
 
 namespace   Html
 {
-    void    massageElement (Element& element);
+    namespace   Markdown
+    {
+        extern  bool    wrapInParagraph (const Tag tag);
+
+        extern  bool    mergeWithList (const Element* lastSubElement);
+        extern  bool    mergeWithParagraph (const string& firstText, const Element* firstSubElement);
+
+        extern  bool    codeBlock (const Tag parentTag, const Tag tag);
+        extern  bool    renameCodeBlock (const bool firstPart, const string& text);
+
+        extern  bool    shuffleComment (const string& text);
+
+        extern  bool    termsInCodeSpan (const string& text, vector< size_t >& delimiters);
+    };
 };
 
 # endif  /* _MASSAGE_H */
@@ -19,8 +19,10 @@
 //
 //----------------------------------------------------------------------------//
 
+#include "Allocs.h"
 #include "Dialogue.h"
 #include "Html.h"
+#include "Loader.h"
 #include "Quiz.h"
 #include "SectionNumber.h"
 
@@ -28,6 +30,8 @@
 #include <deque>
 #include <iostream>
 #include <string>
+#include <utility>
+#include <vector>
 
 using namespace std;
 
@@ -46,11 +50,15 @@ namespace       Quiz
 
         static  bool    paragraphs (const ContentsIterator& first, const ContentsIterator& last, const int choices, int &maxTermCount);
 
+        // the quiz header before the delegates
+
+        static  bool    tome (SectionNumber& prefix, const ContentsIterator& first, const ContentsIterator& last, bool& questions);
+
         // two helper routines used by the delegates
 
-        static  void    findHeaderTags (ContentsList& markers, const ContentsIterator& first, const ContentsIterator& last, const string& markerTag);
+        static  void    findHeaderTags (ContentsList& markers, const ContentsIterator& first, const ContentsIterator& last, const Html::Tag markerTag);
 
-        static  void    findTermTags (ContentsList& terms, const ContentsIterator& first, const ContentsIterator& last, const string& termTag);
+        static  void    findTermTags (ContentsList& terms, const ContentsIterator& first, const ContentsIterator& last, const Html::Tag termTag);
 
         // the shuffle routines used by paragraphs()
 
@@ -97,17 +105,92 @@ namespace       Quiz
 // crib sheet at a level above the quiz master.  Hence the use of static data
 // at the namespace level.
 //
+// A streamed cribsheet arrives as the parts of the element holding the
+// chapters, a chapter at a time (see Html.h).  Each is processed as soon as
+// it arrives just as Process::chapters() would had it the whole element.
+// The stream assumes the element holding the chapters is the element that
+// holds the quiz questions, as it is in any cribsheet with chapters.
+//
 //----------------------------------------------------------------------------//
 
 //----  run quiz, chapter by chapter, section by section and paragraph by paragraph
 
 void    Quiz::run (SectionNumber& prefix, Html::Element& quiz, int choices)
 {
-    ContentsIterator  it;
+    Allocs::Scope   scope (Allocs::render);
+
+    vector< Html::Element* >    stack (1, &quiz);   // the elements to look in for quiz questions, the next last
+
+    while (!stack.empty())
+    {
+        Html::Element&  element = *stack.back();
+
+        stack.pop_back();
+
+        // look in this element for quiz questions
+
+        bool    questions = false;
+
+        if (Process::tome(prefix, element.contents.begin(), element.contents.end(), questions))
+            continue;
+
+        if (questions)
+        {
+            // quiz questions found - process chapters/sections/paragraphs
+
+            Process::chapters(prefix, element.contents.begin(), element.contents.end(), choices);
+
+            continue;
+        }
+
+        // no quiz questions found - try all sub elements, in order
+
+        for (size_t ii = element.contents.size(); ii-- > 0; )
+            if (element.contents[ii].subElement)
+                stack.push_back(element.contents[ii].subElement);
+    }
+}
+
+//----  run quiz on a streamed cribsheet, chapter by chapter as each is parsed
+
+bool    Quiz::run (SectionNumber& prefix, Loader& loader, size_t index, int choices)
+{
+    Allocs::Scope   scope (Allocs::render);
+
+    Html::Element*  chapter = loader.chapter(index);
+
+    if (chapter == 0)
+    {
+        // no chapters - the parse tree is whole, if there is one
+
+        Html::Element*  quiz = loader.wait(index);
+
+        if (quiz)
+            run (prefix, *quiz, choices);
+
+        return (quiz != 0);
+    }
+
+    bool    questions = false;
+
+    for (; chapter != 0; chapter = loader.chapter(index))
+    {
+        Html::ElementContents&  contents = chapter->contents;
+
+        if (!questions && Process::tome(prefix, contents.begin(), contents.end(), questions))
+            break;
 
-    // look in this quiz element for quiz questions
+        Process::chapters(prefix, contents.begin(), contents.end(), choices);
+    }
 
-    for (it = quiz.contents.begin(); it != quiz.contents.end(); ++it)
+    return (true);
+}
+
+//----  print the tome header, if any, before the first quiz question - returns true to skip the quiz
+
+bool    Quiz::Process::tome (SectionNumber& prefix, const ContentsIterator& first, const ContentsIterator& last, bool& questions)
+{
+    for (ContentsIterator it = first; it != last; ++it)
     {
         if (it->subElement == 0)
             continue;
@@ -116,11 +199,9 @@ void    Quiz::run (SectionNumber& prefix, Html::Element& quiz, int choices)
 
         if (element.tag == Html::Markup::para)
         {
-            // quiz questions found - process chapters/sections/paragraphs
+            questions = true;
 
-            Process::chapters(prefix, quiz.contents.begin(), quiz.contents.end(), choices);
-
-            return;
+            return (false);
         }
         else if (element.tag == Html::Markup::hdr1)
         {
@@ -137,16 +218,12 @@ void    Quiz::run (SectionNumber& prefix, Html::Element& quiz, int choices)
                 else if (prefix.doubleDigit())
                     cout << prefix.quiz(header) << endl << endl;
                 else if (Dialogue::skipYesNo("\n" + tomeHeader))
-                    return;
+                    return (true);
             }
         }
     }
 
-    // no quiz questions found - try all sub elements
-
-    for (it = quiz.contents.begin(); it != quiz.contents.end(); ++it)
-        if (it->subElement)
-            run (prefix, *it->subElement, choices);
+    return (false);
 }
 
 //----------------------------------------------------------------------------//
@@ -307,7 +384,7 @@ bool    Quiz::Process::paragraphs (const ContentsIterator& first, const Contents
 
 //----  build a list of header tags from a (non-recursive) list (of elements)
 
-void    Quiz::Process::findHeaderTags (ContentsList& markers, const ContentsIterator& first, const ContentsIterator& last, const string& tag)
+void    Quiz::Process::findHeaderTags (ContentsList& markers, const ContentsIterator& first, const ContentsIterator& last, const Html::Tag tag)
 {
     for (ContentsIterator it = first; it != last; ++it)
     {
@@ -325,10 +402,25 @@ void    Quiz::Process::findHeaderTags (ContentsList& markers, const ContentsIter
 
 //----  build a list of (maskable) term tags from a (recursive) list (of elements)
 
-void    Quiz::Process::findTermTags (ContentsList& terms, const ContentsIterator& first, const ContentsIterator& last, const string& tag)
+void    Quiz::Process::findTermTags (ContentsList& terms, const ContentsIterator& first, const ContentsIterator& last, const Html::Tag tag)
 {
-    for (ContentsIterator it = first; it != last; ++it)
+    typedef pair< ContentsIterator, ContentsIterator >  Range;
+
+    vector< Range >     stack (1, Range (first, last));     // the parts yet to search, the innermost last
+
+    while (!stack.empty())
     {
+        Range&  range = stack.back();
+
+        if (range.first == range.second)
+        {
+            stack.pop_back();
+
+            continue;
+        }
+
+        const ContentsIterator  it = range.first++;
+
         if (it->subElement == 0)
             continue;
 
@@ -337,7 +429,7 @@ void    Quiz::Process::findTermTags (ContentsList& terms, const ContentsIterator
         if (subElement.tag == tag)
             terms.push_back(it);
         else
-            findTermTags(terms, subElement.contents.begin(), subElement.contents.end(), tag);
+            stack.push_back(Range (subElement.contents.begin(), subElement.contents.end()));
     }
 }
 
@@ -371,7 +463,7 @@ void    Quiz::Process::shuffleParagraphs (const ContentsIterator& first, const C
 
         const Html::Element&    element = *it->subElement;
 
-        if (element.tag == Html::Comment::beg && !element.contents.empty())
+        if (element.tag == Html::Markup::comment && !element.contents.empty())
         {
             const string& comment =  element.contents.front().text;
 
@@ -417,7 +509,7 @@ void    Quiz::Process::shuffleOrderedLists (Html::Element& paragraph)
 
         const Html::Element&  element = *it->subElement;
 
-        if (element.tag != Html::Comment::beg || element.contents.empty()) continue;
+        if (element.tag != Html::Markup::comment || element.contents.empty()) continue;
 
         // shuffle list contents if so directed
 
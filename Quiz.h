@@ -29,6 +29,7 @@
 
 using namespace std;
 
+class   Loader;
 class   SectionNumber;
 
 //----------------------------------------------------------------------------//
@@ -38,6 +39,11 @@ class   SectionNumber;
 //    - quiz - the top level element of the parsed html cribsheet contents
 //    - choices - (from the command line) the number of terms to blank
 //
+// A second form runs the quiz on a cribsheet that is streamed (see Loader.h)
+// a chapter at a time, starting before the rest is parsed.  It is passed the
+// loader and the index of the cribsheet in place of quiz and returns false
+// if the cribsheet was not found.
+//
 // For implementation details see Quiz.cpp.
 //
 // Two typedefs appear in the interface because they are part of the interface
@@ -59,6 +65,7 @@ namespace       Quiz
     // only one external routine - called from main
 
     extern  void    run (SectionNumber& prefix, Html::Element& quiz, int choices);
+    extern  bool    run (SectionNumber& prefix, Loader& loader, size_t index, int choices);
 };
 
 # endif  /* _QUIZ_H */
@@ -0,0 +1,388 @@
+//----------------------------------------------------------------------------//
+//
+// Implementation file for the Terms::Spellings namespace of the cribtutor
+// program.
+//
+// The Terms::Spellings namespace holds the rules for alternative spellings
+// and plurals and compares words by them.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include "Spellings.h"
+
+#include <cctype>
+#include <cstring>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------//
+//
+// See Spellings.h for a description of the interface.
+//
+// Each rule is kept twice, once each way round, so that a rule is always a
+// spelling found in the left hand word and the alternative that may take its
+// place in the right hand word.
+//
+// The spellings are compiled into a trie, a finite state machine whose states
+// are the prefixes of the spellings.  Characters that appear in no spelling
+// all fall into class 0, which has no transitions, so the table of transitions
+// has a row for each state but only a column for each character that matters.
+// Each state lists the rules whose spelling ends there.  The trie is compiled
+// again each time rules are added.
+//
+// same() walks the two words side by side.  At each position it first tries
+// the rules whose spelling starts there in the left hand word:  the first
+// rule whose alternative is next in the right hand word is taken and both
+// words move on past them.  Otherwise the next characters must be the same.
+// When the words part company, or both run out, what is left of each must be
+// a spelling and the alternative of an ending rule.  The ending may start no
+// earlier than the last rule taken, and both words must have reached it in
+// step.  Rules are taken greedily:  same() does not back track.
+//
+// stem() leaves out the characters by which the two spellings of any rule
+// differ (those left when what they have in common at either end is taken
+// away).  same() matches the words as runs of the same characters and pairs
+// of spellings so, with those characters left out, the words are the same.
+//
+//----------------------------------------------------------------------------//
+
+namespace       Terms
+{
+    namespace   Spellings
+    {
+        struct  Rule
+        {
+            string  spelling;       // in the left hand word
+            string  alternative;    // in its place in the right hand word
+            bool    ending;         // at the end of the words only
+        };
+
+        static  bool    addRule (const string& line);
+
+        static  void    compile (void);
+
+        static  bool    match (const char* lhs, size_t& ll, const size_t lhsLength, const char* rhs, size_t& rr, const size_t rhsLength, const bool ending);
+
+        static  vector< Rule >      rules;
+
+        // the trie
+
+        static  unsigned short      classes[256];       // of each character:  0 if in no spelling
+        static  size_t              columns;            // of the transitions:  one for each class
+
+        static  vector< size_t >    transitions;        // to the next state:  0 for none
+        static  vector< size_t >    firstRule;          // of the rules of each state (and one more)
+        static  vector< size_t >    stateRules;         // indices into rules
+
+        static  size_t              longestEnding;      // the longest spelling of an ending rule
+
+        // the characters stem() leaves out
+
+        static  bool                changes[256];
+
+        // the built in rules
+
+        static  const char* const   builtIn[] =
+        {
+            "isation ization",  "ise ize",  "ice ise",  "our or",
+            "man men",  "sis ses",  "cis ces",  "xis xes",
+            "- -s",  "- -es",  "-us -i",  "-f -ves",  "-y -ies"
+        };
+
+        static  const struct   BuiltIn
+        {
+            BuiltIn ()
+            {
+                for (size_t ii = 0; ii < sizeof(builtIn) / sizeof(builtIn[0]); ++ii)
+                    addRule(builtIn[ii]);
+
+                compile();
+            }
+        }
+        builtInRules;
+    };
+};
+
+//----  add the rules of a file to those already known
+
+bool    Terms::Spellings::load (const string& pathName)
+{
+    ifstream    file (pathName.c_str(), ios_base::in);
+
+    if (!file)
+        return (false);
+
+    string  line;
+
+    while (getline(file, line))
+    {
+        const size_t    pos = line.find("#");
+
+        if (pos != string::npos)
+            line.erase(pos);
+
+        if (line.find_first_not_of(" \t\r") == string::npos)
+            continue;
+
+        if (!addRule(line))
+            cerr << "Not recognised: '" << line << "' in '" << pathName << "'" << endl;
+    }
+
+    compile();
+
+    return (true);
+}
+
+//----  add a rule, both ways round, from a line of two spellings
+
+bool    Terms::Spellings::addRule (const string& line)
+{
+    istringstream   stream (line);
+
+    string  lhs, rhs, extra;
+
+    if (!(stream >> lhs >> rhs) || (stream >> extra))
+        return (false);
+
+    const bool  ending = (lhs[0] == '-');
+
+    if (ending != (rhs[0] == '-'))
+        return (false);
+
+    if (ending)
+    {
+        lhs.erase(0, 1);
+        rhs.erase(0, 1);
+    }
+
+    if (lhs == rhs || (!ending && (lhs.empty() || rhs.empty())))
+        return (false);
+
+    Rule    rule = { lhs, rhs, ending };
+
+    rules.push_back(rule);
+
+    swap(rule.spelling, rule.alternative);
+
+    rules.push_back(rule);
+
+    return (true);
+}
+
+//----  compile the spellings of the rules into a trie
+
+void    Terms::Spellings::compile (void)
+{
+    // a class for each character in a spelling
+
+    memset(classes, 0, sizeof(classes));
+
+    columns = 1;
+
+    for (vector< Rule >::const_iterator it = rules.begin(); it != rules.end(); ++it)
+        for (size_t ii = 0; ii < it->spelling.length(); ++ii)
+        {
+            unsigned short& cls = classes[(unsigned char) it->spelling[ii]];
+
+            if (cls == 0)
+                cls = columns++;
+        }
+
+    // add the spellings to the trie one by one
+
+    transitions.assign(columns, 0);
+
+    vector< vector< size_t > >  ruleLists (1);
+
+    longestEnding = 0;
+
+    for (size_t rr = 0; rr < rules.size(); ++rr)
+    {
+        const string&   spelling = rules[rr].spelling;
+
+        size_t  state = 0;
+
+        for (size_t ii = 0; ii < spelling.length(); ++ii)
+        {
+            const size_t    at = state * columns + classes[(unsigned char) spelling[ii]];
+
+            if (transitions[at] == 0)
+            {
+                transitions[at] = ruleLists.size();
+                transitions.resize(transitions.size() + columns, 0);
+
+                ruleLists.push_back(vector< size_t > ());
+            }
+
+            state = transitions[at];
+        }
+
+        ruleLists[state].push_back(rr);
+
+        if (rules[rr].ending && spelling.length() > longestEnding)
+            longestEnding = spelling.length();
+    }
+
+    // flatten the rules of each state
+
+    firstRule.clear();
+    stateRules.clear();
+
+    for (size_t ss = 0; ss < ruleLists.size(); ++ss)
+    {
+        firstRule.push_back(stateRules.size());
+        stateRules.insert(stateRules.end(), ruleLists[ss].begin(), ruleLists[ss].end());
+    }
+
+    firstRule.push_back(stateRules.size());
+
+    // note the characters by which the spellings of each rule differ
+
+    memset(changes, 0, sizeof(changes));
+
+    for (vector< Rule >::const_iterator it = rules.begin(); it != rules.end(); ++it)
+    {
+        const string&   lhs = it->spelling;
+        const string&   rhs = it->alternative;
+
+        size_t  head = 0;
+
+        while (head < lhs.length() && head < rhs.length() && lhs[head] == rhs[head])
+            ++head;
+
+        size_t  tail = 0;
+
+        while (tail < lhs.length() - head && tail < rhs.length() - head && lhs[lhs.length() - 1 - tail] == rhs[rhs.length() - 1 - tail])
+            ++tail;
+
+        for (size_t ii = head; ii < lhs.length() - tail; ++ii)
+        {
+            changes[(unsigned char) lhs[ii]] = true;
+            changes[(unsigned char) tolower(lhs[ii])] = true;
+        }
+    }
+}
+
+//----  compare two words by the rules
+
+bool    Terms::Spellings::same (const char* lhsText, const size_t lhsLength, const char* rhsText, const size_t rhsLength)
+{
+    if (lhsLength == rhsLength && memcmp(lhsText, rhsText, lhsLength) == 0)
+        return (true);
+
+    // walk the words side by side, from where the last rule was taken
+
+    size_t  ll = 0, rr = 0;
+    size_t  lhsStep = 0, rhsStep = 0;
+
+    while (true)
+    {
+        if (match(lhsText, ll, lhsLength, rhsText, rr, rhsLength, false))
+        {
+            lhsStep = ll;
+            rhsStep = rr;
+        }
+        else if (ll < lhsLength && rr < rhsLength && lhsText[ll] == rhsText[rr])
+        {
+            ++ll;
+            ++rr;
+        }
+        else
+            break;
+    }
+
+    if (ll == lhsLength && rr == rhsLength)
+        return (true);
+
+    // the rest of the words must be the spellings of an ending
+
+    const size_t    earliest = lhsLength > longestEnding ? lhsLength - longestEnding : 0;
+
+    for (size_t at = max(lhsStep, earliest); at <= ll; ++at)
+    {
+        size_t  lhsAt = at;
+        size_t  rhsAt = rhsStep + (at - lhsStep);
+
+        if (match(lhsText, lhsAt, lhsLength, rhsText, rhsAt, rhsLength, true))
+            return (true);
+    }
+
+    return (false);
+}
+
+//----  take the first rule whose spelling and alternative come next in the words
+
+bool    Terms::Spellings::match (const char* lhs, size_t& ll, const size_t lhsLength, const char* rhs, size_t& rr, const size_t rhsLength, const bool ending)
+{
+    size_t  state = 0;
+
+    for (size_t ii = ll; ; ++ii)
+    {
+        // a rule that ends here must end both words as well if it is an ending
+
+        if (ending ? ii == lhsLength : ii > ll)
+        {
+            for (size_t ss = firstRule[state]; ss < firstRule[state + 1]; ++ss)
+            {
+                const Rule&     rule = rules[stateRules[ss]];
+
+                if (rule.ending != ending)
+                    continue;
+
+                const size_t    length = rule.alternative.length();
+
+                if (ending ? rhsLength - rr != length : rhsLength - rr < length)
+                    continue;
+
+                if (memcmp(rhs + rr, rule.alternative.data(), length) != 0)
+                    continue;
+
+                ll = ii;
+                rr += length;
+
+                return (true);
+            }
+        }
+
+        if (ii == lhsLength || (state = transitions[state * columns + classes[(unsigned char) lhs[ii]]]) == 0)
+            return (false);
+    }
+}
+
+//----  hash the characters of a word that no rule changes
+
+size_t  Terms::Spellings::stem (const char* word, const size_t length)
+{
+    // FNV-1a
+
+    const size_t    basis = sizeof(size_t) > 4 ? size_t (14695981039346656037ULL) : size_t (2166136261UL);
+    const size_t    prime = sizeof(size_t) > 4 ? size_t (1099511628211ULL) : size_t (16777619UL);
+
+    size_t  hash = basis;
+
+    for (size_t ii = 0; ii < length; ++ii)
+    {
+        const unsigned char     ch = ii > 0 ? word[ii] : tolower(word[ii]);
+
+        if (!changes[ch])
+            hash = (hash ^ ch) * prime;
+    }
+
+    return (hash);
+}
+
+// EOF
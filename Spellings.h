@@ -0,0 +1,78 @@
+# ifndef    _SPELLINGS_H
+# define    _SPELLINGS_H
+
+//----------------------------------------------------------------------------//
+//
+// Interface file for the Terms::Spellings namespace of the cribtutor program.
+//
+// A response need not spell a term exactly as the cribsheet does:  -ise and
+// -ize, -our and -or, singular and plural are all accepted (see Terms.cpp).
+// The Terms::Spellings namespace holds the rules that say which spellings
+// are accepted for which and compares words by them.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include <cstddef>
+#include <string>
+
+using namespace std;
+
+//----------------------------------------------------------------------------//
+//
+// A rule is a pair of spellings either of which may be written for the other.
+// Rules are written one to a line, as the two spellings separated by space:
+//
+//      ise     ize         - anywhere in a word
+//      -f      -ves        - at the end of a word (half and halves)
+//      -       -s          - the empty ending (term and terms)
+//
+// The spellings of a rule that applies at the end of a word both start with
+// a '-'.  As in cribsheets.txt, '#' starts a comment and blank lines are
+// ignored.
+//
+// The program has rules built in for -isation/-ization, -ise/-ize, -ice/-ise,
+// -our/-or, -man/-men, -sis/-ses (and -cis/-ces, -xis/-xes) and the regular
+// plurals -s, -es, -us/-i, -f/-ves and -y/-ies.  Terms::Spellings::load()
+// adds the rules of a file to them.  The program loads spellings.txt from
+// the directory of cribsheets.txt, if there is one, before the quiz starts.
+// The rules do not change once it has.
+//
+// There are two other interface routines:
+//    - same() compares two words by the rules
+//    - stem() returns a hash of the letters of a word that no rule changes,
+//      with the first letter folded to lower case:  words that are the same
+//      by the rules have the same stem
+//
+// Neither allocates memory.  Each takes its words either as strings or as
+// characters and a length so that words need not be copied out of the text
+// they are found in (see splitIntoWords() in Terms.cpp).
+//
+// For implementation details see Spellings.cpp.
+//
+//----------------------------------------------------------------------------//
+
+namespace       Terms
+{
+    namespace   Spellings
+    {
+        extern  bool    load (const string& pathName);
+
+        extern  bool    same (const char* lhs, size_t lhsLength, const char* rhs, size_t rhsLength);
+
+        inline  bool    same (const string& lhs, const string& rhs)     {return (same(lhs.data(), lhs.length(), rhs.data(), rhs.length()));}
+
+        extern  size_t  stem (const char* word, size_t length);
+
+        inline  size_t  stem (const string& word)                       {return (stem(word.data(), word.length()));}
+    };
+};
+
+# endif  /* _SPELLINGS_H */
@@ -0,0 +1,170 @@
+//----------------------------------------------------------------------------//
+//
+// Implementation file for the Stats namespace of the cribtutor program.
+//
+// The Stats namespace times the phases of a run and counts the work done.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include "Stats.h"
+#include "Lock.h"
+
+#include <iomanip>
+
+#include <time.h>
+
+using namespace std;
+
+//----------------------------------------------------------------------------//
+//
+// See Stats.h for a description of the interface.
+//
+// A thread's Totals are allocated when it first counts and linked into the
+// list of all Totals, the only time it takes the mutex.  They are never
+// released:  the totals of a thread that has finished still count and those
+// of threads still running at exit must not be freed from under them.
+//
+//----------------------------------------------------------------------------//
+
+namespace       Stats
+{
+    static  unsigned long long  now (clockid_t clock);
+
+    static  Totals*     all = 0;        // the Totals of every thread that has counted
+
+    static  pthread_mutex_t     mutex = PTHREAD_MUTEX_INITIALIZER;
+
+    static  const unsigned long long    started = now(CLOCK_MONOTONIC);
+};
+
+__thread Stats::Totals*     Stats::totals = 0;
+__thread Stats::Timer*      Stats::Timer::innermost = 0;
+
+bool    Stats::enabled = false;
+
+//----  allocate the Totals of this thread
+
+Stats::Totals&  Stats::attach (void)
+{
+    totals = new Totals ();
+
+    Lock    lock (mutex);
+
+    totals->next = all;
+
+    all = totals;
+
+    return (*totals);
+}
+
+//----  enter a phase and, if enabled, start the clocks
+
+Stats::Timer::Timer (const Phase phase) :
+    phase (phase),
+    running (enabled),
+    wall (0),
+    cpu (0),
+    outer (0)
+{
+    (totals ? *totals : attach()).calls[phase] += 1;
+
+    if (running)
+    {
+        outer = innermost;
+        innermost = this;
+
+        wall = now(CLOCK_MONOTONIC);
+        cpu = now(CLOCK_THREAD_CPUTIME_ID);
+    }
+}
+
+//----  stop the clocks and add the time taken to the phase
+
+void    Stats::Timer::stop (void)
+{
+    if (!running)
+        return;
+
+    running = false;
+
+    totals->wall[phase] += now(CLOCK_MONOTONIC) - wall;
+    totals->cpu[phase] += now(CLOCK_THREAD_CPUTIME_ID) - cpu;
+
+    if (innermost == this)
+        innermost = outer;
+}
+
+//----  print the totals of all threads
+
+void    Stats::report (ostream& stream)
+{
+    while (Timer::innermost)
+        Timer::innermost->stop();
+
+    Totals  sum = Totals ();
+
+    {
+        Lock    lock (mutex);
+
+        for (const Totals* it = all; it; it = it->next)
+        {
+            for (int ii = 0; ii < phases; ++ii)
+            {
+                sum.calls[ii] += it->calls[ii];
+                sum.wall[ii] += it->wall[ii];
+                sum.cpu[ii] += it->cpu[ii];
+            }
+
+            for (int ii = 0; ii < counters; ++ii)
+                sum.counts[ii] += it->counts[ii];
+        }
+    }
+
+    static  const char* const   names[phases] = { "list", "read", "cache", "parse", "render", "  mask", "  check" };
+
+    const ios_base::fmtflags    flags = stream.flags();
+    const streamsize            precision = stream.precision();
+
+    stream << fixed << setprecision(3);
+
+    stream << "Statistics:" << endl;
+    stream << "    phase       calls      wall ms       cpu ms" << endl;
+
+    for (int ii = 0; ii < phases; ++ii)
+    {
+        stream << "    " << left << setw(8) << names[ii] << right << setw(9) << sum.calls[ii];
+        stream << setw(13) << sum.wall[ii] / 1e6 << setw(13) << sum.cpu[ii] / 1e6 << endl;
+    }
+
+    stream << "    total   " << setw(9) << "" << setw(13) << (now(CLOCK_MONOTONIC) - started) / 1e6 << setw(13) << now(CLOCK_PROCESS_CPUTIME_ID) / 1e6 << endl;
+
+    stream << "    elements created:     " << sum.counts[elements] << endl;
+    stream << "    text bytes:           " << sum.counts[textBytes] << endl;
+    stream << "    references replaced:  " << sum.counts[references] << endl;
+    stream << "    fuzzyCompare calls:   " << sum.counts[fuzzyCompares] << endl;
+
+    stream.flags(flags);
+    stream.precision(precision);
+}
+
+//----  read a clock in nanoseconds
+
+unsigned long long  Stats::now (clockid_t clock)
+{
+    struct timespec     time;
+
+    if (clock_gettime(clock, &time) != 0)
+        return (0);
+
+    return (time.tv_sec * 1000000000ULL + time.tv_nsec);
+}
+
+// EOF
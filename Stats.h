@@ -0,0 +1,134 @@
+# ifndef    _STATS_H
+# define    _STATS_H
+
+//----------------------------------------------------------------------------//
+//
+// Interface file for the Stats namespace of the cribtutor program.
+//
+// Where does the time go ?  The Stats namespace times the phases of a run of
+// the program and counts the work done in them so that the question can be
+// answered with numbers.  With the --stats flag, the totals are reported on
+// stderr when the program exits.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include <cstddef>
+#include <iostream>
+
+using namespace std;
+
+//----------------------------------------------------------------------------//
+//
+// A phase is timed by a Timer, a scope guard that adds the wall time and CPU
+// time of its scope to the phase.  A timer may be stopped before its scope
+// ends:
+//
+//      {
+//          Stats::Timer    timer (Stats::parse);
+//          ...
+//      }
+//
+// The phases are:
+//    - list - reading the list of cribsheets
+//    - read - opening or mapping a cribsheet (a mapped cribsheet is read a
+//      page at a time as it is parsed)
+//    - cache - loading and saving parse trees (with --cache)
+//    - parse - parsing a cribsheet:  the parse tree is massaged and annotated
+//      as it is built, not in passes of their own (see Html.cpp)
+//    - render - running the quiz on a cribsheet or printing it
+//    - mask and check - Terms::mask() and Terms::check(), within render
+//
+// The quiz may end the program from within a phase.  The timers still
+// running in the thread that reports are stopped first.
+//
+// Each phase counts the times it is entered.  Stats::count() adds to the
+// other counters:
+//    - elements - the Element objects created
+//    - textBytes - the bytes of text added to parse trees
+//    - references - the character references replaced
+//    - fuzzyCompares - the calls of Terms::fuzzyCompare()
+//
+// Counts and times are kept in Totals of each thread's own, without locks,
+// and added up by Stats::report().  CPU time is that of the thread.  Wall
+// time is added up over the threads so phases run in parallel may take more
+// wall time than the whole run.
+//
+// Counting is always on:  a count is an increment of a thread local total.
+// The clocks are read only when Stats::enabled is set.
+//
+// Stats::report() prints the totals for people, not programs.
+//
+//----------------------------------------------------------------------------//
+
+namespace       Stats
+{
+    enum    Phase
+    {
+        list, read, cache, parse, render, mask, check, phases
+    };
+
+    enum    Counter
+    {
+        elements, textBytes, references, fuzzyCompares, counters
+    };
+
+    struct  Totals
+    {
+        unsigned long long  calls[phases];
+        unsigned long long  wall[phases];       // in nanoseconds
+        unsigned long long  cpu[phases];        // in nanoseconds
+        unsigned long long  counts[counters];
+
+        Totals*     next;                       // those of another thread
+    };
+
+    extern  __thread    Totals*     totals;     // of this thread, once it has counted
+
+    extern  Totals&     attach (void);
+
+    inline  void    count (const Counter counter, const size_t increment = 1)
+    {
+        (totals ? *totals : attach()).counts[counter] += increment;
+    }
+
+    class   Timer
+    {
+    public:
+        explicit Timer (const Phase phase);
+       ~Timer ()    { stop(); }
+
+    public:
+        void    stop (void);
+
+    private:
+        Timer (const Timer&);               // not implemented
+        Timer& operator= (const Timer&);    // not implemented
+
+    private:
+        Phase   phase;
+        bool    running;
+
+        unsigned long long  wall;           // when started
+        unsigned long long  cpu;
+
+        Timer*  outer;                      // the timer running when this one started
+
+        static  __thread    Timer*  innermost;
+
+        friend  void    report (ostream& stream);
+    };
+
+    extern  bool    enabled;
+
+    extern  void    report (ostream& stream);
+};
+
+# endif  /* _STATS_H */
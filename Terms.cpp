@@ -22,10 +22,15 @@
 //----------------------------------------------------------------------------//
 
 #include "Terms.h"
+#include "Allocs.h"
+#include "Spellings.h"
+#include "Stats.h"
 
 #include <cctype>
+#include <cstring>
 
 #include <algorithm>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -48,9 +53,10 @@ using namespace std;
 // Simple terms are blanked with ____.  Compound terms comprise more than one
 // word.  These are blank with a ____ sequence:  one ____ for each word.
 //
-// Element::contentMask is the mask, Terms::mask() and Terms::reset() set and
-// clear the mask while Html::printElement() blanks terms by printing the mask
-// instead of the term.
+// Element::contentMask points to the mask, Terms::mask() and Terms::reset()
+// set and clear the mask while Html::printElement() blanks terms by printing
+// the mask instead of the term.  There are few distinct masks so each is held
+// once, in a table of masks, and elements point into the table.
 //
 // 2.  Hyphenated Terms
 //
@@ -76,7 +82,7 @@ using namespace std;
 // Yes, conjunctions may be strung together into mini-lists of three or more
 // terms and yes, mixing conjunctions is allowed but makes little sense.
 //
-// A single term containing "/" is also treated in Terms::mask() as a
+// A single term containing "/" is also treated by the AnswerKey as a
 // mini-list but it counts as only one choice.  splitIntoWords() allows a
 // user response to include the slash but it is optional.
 //
@@ -104,7 +110,7 @@ using namespace std;
 // should not have to be entered differently simply because of its appears at
 // the start of a sentence.
 //
-// Terms::mask() lowers the case of the first letter of a simple term when
+// The AnswerKey lowers the case of the first letter of a simple term when
 // the term begins a sentence.  Terms::check() checks terms as is and with
 // the case of the first letter lowered.
 //
@@ -114,20 +120,94 @@ using namespace std;
 // 7.   Alternative Spellings
 //
 // English has notoriously eccentric spelling and, in some very common cases,
-// different nations spell the same word differently.  Terms::adjustSpelling()
-// is used to equivalence -ise/-ize, -ice/-ise and -our/-or spellings.
+// different nations spell the same word differently.  Terms::fuzzyCompare()
+// equivalences -ise/-ize, -ice/-ise and -our/-or spellings by the rules of
+// the Terms::Spellings namespace (see Spellings.h), to which a cribsheet
+// author may add their own.
 //
 // 8.   Plurals
 //
 // In some sentences, either the singular term or the plural term make sense.
-// Terms:fuzzyCompare() goes some way to equivalencing regular plurals with
-// the singular.  Not perfect.
+// The rules also go some way to equivalencing regular plurals with the
+// singular.  Not perfect.
+//
+// 9.   Finding Terms
+//
+// Terms::check() looks up each word of the response in the current set of
+// masked terms.  Because of 6, 7 and 8, the word need not be the same as the
+// first word of the term it answers so the lookup is by stem:  the hash of
+// the letters of the word that no spelling rule changes.  Any two words
+// fuzzyCompare() accepts have the same stem.
+//
+// Each set of masked terms is indexed by stem in a small open addressing hash
+// table so one probe finds every candidate term, whatever the size of the
+// set.  Different words may share a stem so the candidates are then checked
+// as before:  exactly, then with the initial letter lowered, then with
+// fuzzyCompare().
+//
+// 10.  Typos
+//
+// Real users make typos.  With --typo, when no term matches a word of the
+// response, every term of the set not yet found is checked for one within the
+// edits allowed and the nearest taken.  A typo may be in any word of the term
+// and the words of the term must otherwise match as before.  The edit distance
+// is found with Myers' bit-parallel algorithm:  a handful of operations on a
+// word of bits for each letter so even a large set takes microseconds.  Words
+// longer than a word of bits are never typos.
 //
 //----------------------------------------------------------------------------//
 
-//----  not Term specific but used here
+//----  not Term specific but used here:  the words of a line, as views of it
+
+struct  Word
+{
+    Word () : text (0), length (0)   {}
+    Word (const char* text, size_t length) : text (text), length (length)   {}
+    Word (const string& word) : text (word.data()), length (word.length())  {}
+
+    const char*     text;
+    size_t          length;
+};
+
+inline  bool    operator== (const string& lhs, const Word& rhs)
+{
+    return (lhs.length() == rhs.length && memcmp(lhs.data(), rhs.text, rhs.length) == 0);
+}
+
+inline  bool    operator!= (const string& lhs, const Word& rhs)     {return (!(lhs == rhs));}
+
+class   WordList
+{
+public:
+    typedef const Word*     const_iterator;
+
+    WordList () : words (local), count (0), capacity (localCapacity), first (0)   {}
+   ~WordList ()     {if (words != local) delete [] words;}
+
+public:
+    bool            empty (void) const  {return (first == count);}
+    const Word&     front (void) const  {return (words[first]);}
+
+    const_iterator  begin (void) const  {return (words + first);}
+    const_iterator  end (void) const    {return (words + count);}
 
-typedef deque< string > WordList;
+    void    push_back (const Word& word);
+    void    pop_front (void)            {++first;}
+
+private:
+    WordList (const WordList&);             // not implemented
+    WordList& operator= (const WordList&);  // not implemented
+
+private:
+    enum    { localCapacity = 16 };
+
+    Word*   words;
+    size_t  count;
+    size_t  capacity;
+    size_t  first;                          // the words before it have been taken
+
+    Word    local[localCapacity];           // most responses need no more
+};
 
 static  void    splitIntoWords (const string& line, WordList& wordList);
 
@@ -149,17 +229,39 @@ inline  size_t  safeEndPosition(size_t epos, const string& text)
     return (epos);
 }
 
+//----  the edits allowed in a word for it to be a typo (--typo)
+
+int     Terms::typos = 0;
+
 //----  local routines
 
 namespace   Terms
 {
+    // order terms by their first word (as the key of a multimap)
+
+    struct  FirstWord
+    {
+        bool    operator() (const CompoundTerm* lhs, const string& rhs) const   { return (lhs->first < rhs); }
+        bool    operator() (const string& lhs, const CompoundTerm* rhs) const   { return (lhs < rhs->first); }
+    };
+
+    static  void    addTerm (MaskedTermList& maskedTerms, const MaskedTerm& term);
+
+    static  void    closeTermSet (MaskedTermList& maskedTerms);
+
     static  CompoundTerm  newTerm (string &contentMask, const string& maskedTerm);
 
-    static  MaskedTermSet::iterator fuzzyFind (MaskedTermSet& termSet, string& term);
+    static  const string*   internMask (const string& contentMask);
 
-    static  bool    fuzzyCompare (string lhs, string rhs);
+    static  bool    matchTerm (const MaskedTerm& term, const Word& key, const WordList& wordList, const bool fuzzy);
 
-    static  void    adjustSpelling (string& lhs, string& rhs, const string& alt1, const string& alt2);
+    static  int     typoTerm (const MaskedTerm& term, const Word& word, const Word& lowered, const WordList& wordList, int& wrong);
+
+    static  int     typoWord (const string& term, const Word& word);
+
+    static  int     editDistance (const Word& lhs, const Word& rhs, const int limit);
+
+    static  bool    fuzzyCompare (const Word& lhs, const Word& rhs);
 };
 
 //----  reset the blanking content mask for all source terms
@@ -173,118 +275,182 @@ void    Terms::reset (SourceTermList& sourceTerms)
 
         Html::Element&  element = *(*it)->subElement;
 
-        element.contentMask.clear();
+        element.contentMask = 0;
     }
 }
 
-//----  create a list of masked terms and set the blanking content mask for each
+//----  note the source terms of a question
 
-int     Terms::mask (MaskedTermList& maskedTerms, SourceTermList& sourceTerms, int termCount, const int choices)
+Terms::AnswerKey::AnswerKey (const SourceTermList& sourceTerms) :
+    terms (sourceTerms.size())
 {
-    maskedTerms.clear();
+    for (size_t ii = 0; ii < sourceTerms.size(); ++ii)
+    {
+        Term&   term = terms[ii];
 
-    // terms to be masked as chosen randomly
+        term.element = 0;
+        term.contentMask = 0;
+        term.first = term.last = 0;
+        term.extra = 0;
+        term.compiled = false;
 
-    vector <int>    shuffle (termCount);
+        // get to the text of the source term safely
 
-    for (int ii = 0; ii < termCount; ++ii)
-        shuffle [ii] = ii;
+        if (sourceTerms[ii]->subElement == 0)
+            continue;
 
-    random_shuffle (shuffle.begin(), shuffle.end());
+        Html::Element&  element = *sourceTerms[ii]->subElement;
 
-    termCount = min(termCount, choices);
+        if (element.contents.empty())
+            continue;
 
-    sort (shuffle.begin(), shuffle.begin() + termCount);
+        term.element = &element;
+    }
+}
 
-    shuffle.resize(termCount);
+//----  compile a source term into its masked terms and content mask
 
-    // mask the chosen terms
+void    Terms::AnswerKey::compile (Term& term)
+{
+    const Html::Element&    element = *term.element;
+
+    term.compiled = true;
+
+    // allow for a lax case comparison of the initial letter of sentences.
+
+    string          termText = element.contents.begin()->text;
+
+    if (element.startOfSentence)
+        if (termText.length() > 1)
+        {
+            size_t  pos = termText.find(" ");
+
+            char    letter = termText[pos == string::npos ? 1 : pos + 1];
+
+            if (letter == tolower(letter))
+                termText[0] = tolower(termText[0]);
+        }
+
+    //  split the term into its alternatives
+
+    string  contentMask;
 
-    MaskedTermSet   termSet;
+    size_t  bpos = 0;
+    size_t  epos = safeEndPosition(termText.find_first_of("/"), termText);
 
-    for (vector< int >::iterator it = shuffle.begin(); it != shuffle.end(); ++it)
+    term.first = alternatives.size();
+
+    while (epos != string::npos)
     {
-        SourceTermIterator&     sourceTerm = *(sourceTerms.begin() + it[0]);
+        // treat a/b/c and a mini-list
 
-        // get to the text of the source term safely
+        const CompoundTerm  alternative = newTerm(contentMask, termText.substr(bpos, epos - bpos));
 
-        if (sourceTerm->subElement == 0)
-            continue;
+        alternatives.push_back(MaskedTerm (alternative, Spellings::stem(alternative.first)));
 
-        Html::Element&  element = *sourceTerm->subElement;
+        contentMask += "/";
 
-        if (element.contents.empty())
-            continue;
+        bpos = epos + 1;
+        epos = safeEndPosition(termText.find_first_of("/", bpos), termText);
 
-        if (element.strictOrder)
-        {
-            // add outstanding set of terms to the list of masked terms
+        ++term.extra;
+    }
 
-            if (!termSet.empty())
-            {
-                maskedTerms.push_back(termSet);
+    if (bpos != termText.length())
+    {
+        const CompoundTerm  alternative = newTerm(contentMask, termText.substr(bpos));
 
-                termSet.clear();
-            }
-        }
+        alternatives.push_back(MaskedTerm (alternative, Spellings::stem(alternative.first)));
+    }
 
-        // allow for a lax case comparison of the initial letter of sentences.
+    term.last = alternatives.size();
+    term.contentMask = contentMask.empty() ? 0 : internMask(contentMask);
+}
 
-        string          termText = element.contents.begin()->text;
+//----  create a list of masked terms and set the blanking content mask for each
 
-        if (element.startOfSentence)
-            if (termText.length() > 1)
-            {
-                size_t  pos = termText.find(" ");
+int     Terms::mask (MaskedTermList& maskedTerms, AnswerKey& answerKey, const int choices)
+{
+    Allocs::Scope   scope (Allocs::mask);
+    Stats::Timer    timer (Stats::mask);
 
-                char    letter = termText[pos == string::npos ? 1 : pos + 1];
+    maskedTerms.clear();
 
-                if (letter == tolower(letter))
-                    termText[0] = tolower(termText[0]);
-            }
+    // terms to be masked as chosen randomly
 
-        //  add new term to current set of terms
+    vector< int >&  shuffle = answerKey.order;
 
-        element.contentMask = "";
+    int     termCount = answerKey.terms.size();
 
-        size_t  bpos = 0;
-        size_t  epos = safeEndPosition(termText.find_first_of("/"), termText);
+    shuffle.resize(termCount);
 
-        while (epos != string::npos)
-        {
-            // treat a/b/c and a mini-list
+    for (int ii = 0; ii < termCount; ++ii)
+        shuffle [ii] = ii;
 
-            termSet.insert(newTerm(element.contentMask, termText.substr(bpos, epos - bpos)));
+    random_shuffle (shuffle.begin(), shuffle.end());
 
-            element.contentMask += "/";
+    const int   chosen = min(termCount, choices);
 
-            bpos = epos + 1;
-            epos = safeEndPosition(termText.find_first_of("/", bpos), termText);
+    sort (shuffle.begin(), shuffle.begin() + chosen);
 
-            ++termCount;
-        }
+    termCount = chosen;
 
-        if (bpos != termText.length())
-            termSet.insert(newTerm(element.contentMask, termText.substr(bpos)));
+    // mask the chosen terms
 
-        if (element.strictOrder)
-        {
-            // add current set of terms to the list of masked terms
+    for (vector< int >::const_iterator it = shuffle.begin(); it != shuffle.begin() + chosen; ++it)
+    {
+        AnswerKey::Term&    term = answerKey.terms[*it];
 
-            maskedTerms.push_back(termSet);
+        if (term.element == 0)
+            continue;
 
-            termSet.clear();
-        }
+        if (!term.compiled)
+            answerKey.compile(term);
+
+        if (term.element->strictOrder)
+            closeTermSet(maskedTerms);      // add outstanding set of terms to the list of masked terms
+
+        //  add the alternatives to the current set of terms
+
+        for (size_t ii = term.first; ii < term.last; ++ii)
+            addTerm(maskedTerms, answerKey.alternatives[ii]);
+
+        termCount += term.extra;
+
+        term.element->contentMask = term.contentMask;
+
+        if (term.element->strictOrder)
+            closeTermSet(maskedTerms);      // add current set of terms to the list of masked terms
     }
 
     // add any outstanding set of terms to the list of masked terms
 
-    if (!termSet.empty())
-        maskedTerms.push_back(termSet);
+    closeTermSet(maskedTerms);
 
     return (termCount);
 }
 
+//----  add a term to the current set of terms, after any with the same first word
+
+void    Terms::addTerm (MaskedTermList& maskedTerms, const MaskedTerm& term)
+{
+    MaskedTermSet&  terms = maskedTerms.terms;
+
+    const MaskedTermSet::iterator   first = terms.begin() + (maskedTerms.ends.empty() ? 0 : maskedTerms.ends.back());
+
+    terms.insert(upper_bound(first, terms.end(), term.first, FirstWord ()), &term);
+}
+
+//----  end the current set of terms, unless it is empty
+
+void    Terms::closeTermSet (MaskedTermList& maskedTerms)
+{
+    const size_t    end = maskedTerms.terms.size();
+
+    if (end != (maskedTerms.ends.empty() ? 0 : maskedTerms.ends.back()))
+        maskedTerms.ends.push_back(end);
+}
+
 //----  construct a (compound) masked term and set the blanking content mask
 
 Terms::CompoundTerm  Terms::newTerm (string &contentMask, const string& term)
@@ -323,10 +489,25 @@ Terms::CompoundTerm  Terms::newTerm (string &contentMask, const string& term)
     return (CompoundTerm (termKey, termValue));
 }
 
+//----  the one copy of a content mask - the table is never destroyed
+
+const string*   Terms::internMask (const string& contentMask)
+{
+    static  set< string >*  masks = new set< string >;
+
+    return (&*masks->insert(contentMask).first);
+}
+
 //----   check a response against the masked terms
 
-bool    Terms::check (const MaskedTermList& maskedTerms, const string& response)
+bool    Terms::check (const MaskedTermList& maskedTerms, const string& response, int* typosFound)
 {
+    Allocs::Scope   scope (Allocs::check);
+    Stats::Timer    timer (Stats::check);
+
+    if (typosFound)
+        *typosFound = 0;
+
     // split the response into a list of words that represent terms
 
     WordList  wordList;
@@ -335,54 +516,121 @@ bool    Terms::check (const MaskedTermList& maskedTerms, const string& response)
 
     // check the masked terms against the response (ordered)
 
-    for (MaskedTermList::const_iterator it = maskedTerms.begin(); it != maskedTerms.end(); ++it)
+    vector< int >   slots;          // the stem index of a set:  empty, a term or a term found
+
+    string  lowerCase;              // a word with its initial letter lowered, when that changes it
+
+    const int   empty = -1;
+
+    size_t  first = 0;
+
+    for (vector< size_t >::const_iterator end = maskedTerms.ends.begin(); end != maskedTerms.ends.end(); ++end)
     {
-        MaskedTermSet   termSet = *it;
+        const MaskedTermSet::const_iterator     termSet = maskedTerms.terms.begin() + first;
+
+        const size_t    size = *end - first;
+
+        first = *end;
+
+        // index the set by stem - a term found is marked by adding the size of the set to its index
+
+        size_t  mask = 1;
+
+        while (mask < 2 * size)
+            mask <<= 1;
+
+        slots.assign(mask--, empty);
+
+        for (size_t ii = 0; ii < size; ++ii)
+        {
+            size_t  slot = termSet[ii]->stem & mask;
+
+            while (slots[slot] != empty)
+                slot = (slot + 1) & mask;
+
+            slots[slot] = ii;
+        }
 
         // check a set of masked terms against the response
 
-        while (!termSet.empty())
+        for (size_t remaining = size; remaining > 0; --remaining)
         {
             if (wordList.empty()) return (false);
 
-            MaskedTermSet::iterator     termit = fuzzyFind (termSet, *wordList.begin());
+            const Word&     word = wordList.front();
+
+            const size_t    stem = Spellings::stem(word.text, word.length);
 
-            if (termit == termSet.end()) return (false);
+            // check for an exact match first, then permit the case of the initial letter to differ, then fuzzy
 
-            // a loop is needed to handle multimap with duplicate keys
+            Word    lowered = word;
 
-            while (true)
+            size_t  found = string::npos;       // the slot of the first term in the set to match
+
+            for (int pass = 0; pass < 3 && found == string::npos; ++pass)
             {
-                WordList::iterator wordit = wordList.begin();
+                if (pass == 1)
+                {
+                    if (word.length == 0 || tolower(word.text[0]) == word.text[0])
+                        continue;
+
+                    lowerCase.assign(word.text, word.length);
+                    lowerCase[0] = tolower(lowerCase[0]);
+
+                    lowered = lowerCase;
+                }
 
-                // check a compound masked term word for word
+                for (size_t slot = stem & mask; slots[slot] != empty; slot = (slot + 1) & mask)
+                {
+                    const int   ii = slots[slot];
 
-                deque< string>::iterator it;
+                    if (size_t (ii) >= size || termSet[ii]->stem != stem || (found != string::npos && slots[found] < ii))
+                        continue;
 
-                for (it = termit->second.begin(); it != termit->second.end(); ++it)
-                     if (++wordit == wordList.end() || !fuzzyCompare (*wordit, *it))
-                         break;
+                    if (matchTerm(*termSet[ii], pass == 0 ? word : lowered, wordList, pass == 2))
+                        found = slot;
+                }
+            }
+
+            // then, if the caller will hear of it, the term with the fewest typos
 
-                if (it == termit->second.end())
-                    break;
+            if (found == string::npos && typosFound && typos > 0)
+            {
+                int     fewest = 0;
+                int     wrong = 0;
 
-                const string&   keyWord = termit->first;
+                for (size_t slot = 0; slot <= mask; ++slot)
+                {
+                    const int   ii = slots[slot];
 
-                if (++termit == termSet.end() || termit->first != keyWord)
-                    return (false);
+                    if (ii == empty || size_t (ii) >= size)
+                        continue;
+
+                    int         words = 0;
+                    const int   edits = typoTerm(*termSet[ii], word, lowered, wordList, words);
+
+                    if (edits < 0 || (found != string::npos && (edits > fewest || (edits == fewest && slots[found] < ii))))
+                        continue;
+
+                    found = slot;
+                    fewest = edits;
+                    wrong = words;
+                }
+
+                if (found != string::npos)
+                    *typosFound += wrong;
             }
 
+            if (found == string::npos) return (false);
+
             // success - discard
 
-            wordList.pop_front();
+            const size_t    words = termSet[slots[found]]->second.size() + 1;
 
-            while (!termit->second.empty())
-            {
-                wordList.pop_front();
-                termit->second.pop_front();
-            }
+            slots[found] += size;
 
-            termSet.erase(termit);
+            for (size_t ii = 0; ii < words; ++ii)
+                wordList.pop_front();
         }
     }
 
@@ -391,133 +639,170 @@ bool    Terms::check (const MaskedTermList& maskedTerms, const string& response)
     return (wordList.empty());
 }
 
-//---   find using a heuristic string compare to allow for alternative spellings and regular plurals
+//---   match a (compound) masked term against the words at the front of the response
+
+bool    Terms::matchTerm (const MaskedTerm& term, const Word& key, const WordList& wordList, const bool fuzzy)
+{
+    if (fuzzy ? !fuzzyCompare(term.first, key) : term.first != key)
+        return (false);
+
+    // check a compound masked term word for word
+
+    WordList::const_iterator    wordit = wordList.begin();
+
+    for (deque< string >::const_iterator it = term.second.begin(); it != term.second.end(); ++it)
+         if (++wordit == wordList.end() || !fuzzyCompare (*wordit, *it))
+             return (false);
+
+    return (true);
+}
+
+//---   match a (compound) masked term, allowing for typos:  return the edits needed or -1
 
-Terms::MaskedTermSet::iterator Terms::fuzzyFind (Terms::MaskedTermSet& termSet, string& term)
+int     Terms::typoTerm (const MaskedTerm& term, const Word& word, const Word& lowered, const WordList& wordList, int& wrong)
 {
-    Terms::MaskedTermSet::iterator     it;
+    int     edits = typoWord(term.first, word);
 
-    // check for an exact match first
+    if (lowered.text != word.text)
+    {
+        const int   lowerEdits = typoWord(term.first, lowered);
 
-    if ((it = termSet.find(term)) != termSet.end())
-        return (it);
+        if (edits < 0 || (lowerEdits >= 0 && lowerEdits < edits))
+            edits = lowerEdits;
+    }
 
-    // permit the case of the initial letter to differ
+    if (edits < 0)
+        return (-1);
 
-    term[0] = tolower(term[0]);
+    wrong = edits > 0;
 
-    if ((it = termSet.find(term)) != termSet.end())
-        return (it);
+    // check a compound masked term word for word
 
-    // if this is a simple term ...
+    WordList::const_iterator    wordit = wordList.begin();
 
-    if (it = termSet.begin(), termSet.size() == 1)
-        return (fuzzyCompare(it->first, term) ? it : termSet.end());
+    for (deque< string >::const_iterator it = term.second.begin(); it != term.second.end(); ++it)
+    {
+        if (++wordit == wordList.end())
+            return (-1);
 
-    // compound terms are a headache (I don't think a fuzzy comparator would work)
+        if (fuzzyCompare(*wordit, *it))
+            continue;
 
-    if ((it = termSet.lower_bound(term)) != termSet.end() && fuzzyCompare(it->first, term))
-        return (it);
+        const int   wordEdits = typoWord(*it, *wordit);
 
-    if ((it = termSet.upper_bound(term)) != termSet.end() && fuzzyCompare(it->first, term))
-        return (it);
+        if (wordEdits < 0)
+            return (-1);
 
-    if ((it = termSet.end(), --it) != termSet.end() && fuzzyCompare(it->first, term))
-        return (it);
+        edits += wordEdits;
+        wrong += 1;
+    }
 
-    return (termSet.end());
+    return (edits);
 }
 
-//---   heuristic string comparison to allow for alternative spellings and regular plurals
+//---   the edits needed to make a word a term, or -1 if too many for a typo
 
-bool    Terms::fuzzyCompare (string lhs, string rhs)
+int     Terms::typoWord (const string& term, const Word& word)
 {
-    // adust terms for common alternative spellings
+    if (fuzzyCompare(term, word))
+        return (0);
 
-    adjustSpelling (lhs, rhs, "isation", "ization");
-    adjustSpelling (lhs, rhs, "ise", "ize");
-    adjustSpelling (lhs, rhs, "ice", "ise");
-    adjustSpelling (lhs, rhs, "our", "or");
+    const int   limit = min(typos, (int (term.length()) - 1) / 2);     // fewer than half the letters
 
-    // ensure lhs is the shorter (singular) term
+    const int   edits = editDistance(term, word, limit);
 
-    int     lhslen = lhs.length();
-    int     rhslen = rhs.length();
+    return (edits <= limit ? edits : -1);
+}
 
-    if (lhslen > rhslen)
-    {
-        swap(lhs, rhs);
-        swap(lhslen, rhslen);
-    }
+//---   the edit distance between two words, or more than limit (Myers' bit-parallel algorithm)
 
-    // be prepared to tamper with the final character of the singular term
+int     Terms::editDistance (const Word& lhs, const Word& rhs, const int limit)
+{
+    typedef unsigned long long  Bits;
 
-    char&   lhsend = lhs[lhslen -1];
+    const bool      swapped = lhs.length > rhs.length;
 
-    switch (rhslen - lhslen)
-    {
-        case (0):
-            // same length - either equal or irregluar plural like woman <-> women
+    const char* const   pattern = swapped ? rhs.text : lhs.text;    // the shorter, one letter to a bit
+    const char* const   text = swapped ? lhs.text : rhs.text;
 
-            if (lhs == rhs) return (true);
+    const int   mm = swapped ? rhs.length : lhs.length;
+    const int   nn = swapped ? lhs.length : rhs.length;
 
-            adjustSpelling (lhs, rhs, "man", "men");
+    if (nn - mm > limit || mm > int (8 * sizeof(Bits)))
+        return (limit + 1);
 
-            if (lhs == rhs) return (true);
+    if (mm == 0)
+        return (nn);
 
-            adjustSpelling (lhs, rhs, "sis", "ses");
-            adjustSpelling (lhs, rhs, "cis", "ces");
-            adjustSpelling (lhs, rhs, "xis", "xes");
+    // the bits of the letters of the pattern - only those of letters in the pattern are set
 
-            if (lhs == rhs) return (true);
+    Bits    equal[256];
+    Bits    present[256 / 64] = { 0, 0, 0, 0 };
 
-            break;
+    for (int ii = 0; ii < mm; ++ii)
+    {
+        const unsigned char     ch = pattern[ii];
 
-        case (1):
-            // one character shorter so possibly regular weak plural
+        if (!(present[ch / 64] & (Bits (1) << (ch % 64))))
+        {
+            present[ch / 64] |= Bits (1) << (ch % 64);
+            equal[ch] = 0;
+        }
 
-            if (lhs + "s" == rhs) return (true);
+        equal[ch] |= Bits (1) << ii;
+    }
 
-            // perhaps latin e.g.  focus <-> foci
+    // the vertical deltas of a column of the edit distance matrix, a column for each letter of the text
 
-            if (lhsend == 'i')
-                lhsend = 'u';
+    Bits    positive = ~Bits (0);
+    Bits    negative = 0;
 
-            if (lhs + "s" == rhs) return (true);
+    const Bits  last = Bits (1) << (mm - 1);
 
-            break;
+    int     distance = mm;
 
-        case (2):
-            // two characters shorter so something like potato <-> potatoes
+    for (int jj = 0; jj < nn; ++jj)
+    {
+        const unsigned char     ch = text[jj];
 
-            if (lhs + "es" == rhs) return (true);
+        const Bits  eq = (present[ch / 64] & (Bits (1) << (ch % 64))) ? equal[ch] : 0;
 
-            // perhaps half <-> halves or country <-> countries
+        const Bits  xv = eq | negative;
+        const Bits  xh = (((eq & positive) + positive) ^ positive) | eq;
 
-            if (lhsend == 'f')
-                lhsend = 'v';
-            else if (lhsend == 'y')
-                lhsend = 'i';
+        Bits    ph = negative | ~(xh | positive);
+        Bits    mh = positive & xh;
 
-            if (lhs + "es" == rhs) return (true);
+        if (ph & last)
+            ++distance;
+        else if (mh & last)
+            --distance;
 
-            break;
+        if (distance - (nn - jj - 1) > limit)
+            return (limit + 1);
+
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+
+        positive = mh | ~(xv | ph);
+        negative = ph & xv;
     }
 
-    return (false);
+    return (distance);
 }
 
-//---   adjust spelling (e.g practice and practise so they may compare equal)
+//---   compare words by the spelling rules to allow for alternative spellings and regular plurals
 
-void    Terms::adjustSpelling (string& lhs, string& rhs, const string& alt1, const string& alt2)
+bool    Terms::fuzzyCompare (const string& lhs, const string& rhs)
 {
-    int     pos;
+    return (fuzzyCompare(Word (lhs), Word (rhs)));
+}
 
-    if ((pos = lhs.find(alt1)) != string::npos && rhs.rfind(alt2) == pos)
-        rhs.replace(pos, alt2.length(), alt1);
+bool    Terms::fuzzyCompare (const Word& lhs, const Word& rhs)
+{
+    Stats::count(Stats::fuzzyCompares);
 
-    if ((pos = lhs.find(alt2)) != string::npos && rhs.rfind(alt1) == pos)
-        rhs.replace(pos, alt1.length(), alt2);
+    return (Spellings::same(lhs.text, lhs.length, rhs.text, rhs.length));
 }
 
 //----------------------------------------------------------------------------//
@@ -542,20 +827,43 @@ void    Terms::adjustSpelling (string& lhs, string& rhs, const string& alt1, con
 // Yes, this does mean that the hyphen and slash may be used in responses
 // between any two words, not just those where it is reasonable.
 //
+// The words are not copied out of the line:  each is a Word, the start and
+// length of its characters in the line, so the line must outlive them.  The
+// punctuation is dropped by shortening the Word.  A WordList keeps its first
+// few Words in place and only allocates for a longer response.  Terms::check()
+// takes words from the front of the list by moving past them.
+//
 //----------------------------------------------------------------------------//
 
-//--- drop trailing ',' ';' or '.' from a word
+//--- add a word to the end of the list, moving the list to the heap when it outgrows its own
 
-inline  void    dropTrailingPuncutation (string& word)
+void    WordList::push_back (const Word& word)
 {
-    const size_t    len = word.length();
+    if (count == capacity)
+    {
+        Word* const     more = new Word [capacity *= 2];
+
+        copy(words, words + count, more);
+
+        if (words != local)
+            delete [] words;
+
+        words = more;
+    }
 
-    if (len > 0)
+    words[count++] = word;
+}
+
+//--- drop trailing ',' ';' or '.' from a word
+
+inline  void    dropTrailingPuncutation (Word& word)
+{
+    if (word.length > 0)
     {
-        const char& end = word[len - 1];
+        const char& end = word.text[word.length - 1];
 
         if (end == ';' || end == ',' || end == '.')
-            word.erase(len - 1);
+            --word.length;
     }
 }
 
@@ -604,9 +912,9 @@ void    splitIntoWords (const string& line, WordList& wordList)
         if (checkNextTokenIsWord(line, bpos, epos))
             epos = line.find_first_of(" -/", bpos);
 
-        // extract current word from line and add to list
+        // add current word to list
 
-        string  word = line.substr(bpos, safeLength(bpos, epos));
+        Word    word (line.data() + bpos, (epos == string::npos ? line.length() : epos) - bpos);
 
         dropTrailingPuncutation(word);
 
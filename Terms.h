@@ -27,6 +27,7 @@
 #include "Quiz.h"
 
 #include <string>
+#include <vector>
 
 using namespace std;
 
@@ -67,28 +68,110 @@ namespace       Terms
 // A snag arises when a unordered list comprises two or more compound terms
 // that start with the same word.  A simple set (or map) is not enough.
 //
-// To solve these problems, the set is replaced with a multimap.  The keys are
-// the first words of compound terms or the term itself for simple terms.  The
-// values are deques that are empty for simple terms but for compound terms
-// contain the remaining words in order.
+// To solve these problems, a term is split into its first word and a deque
+// of the rest, which is empty for simple terms but for compound terms holds
+// the remaining words in order.  A set holds the terms sorted by their first
+// words, as a multimap would, so that terms that start with the same word
+// are next to each other.
 //
-// So a deque of maps of deques.  This is only a simple program.
+// The terms are split once for each question, not for each attempt at it,
+// (see AnswerKey below) so a set holds pointers to terms, not the terms.  The
+// sets of a list are kept one after another in one vector, with the end of
+// each in another, so that a list may be cleared and filled again without
+// allocating memory.
+//
+// A masked term also carries the hash of the stem of its first word, which
+// is all Terms::check() needs to find the term from a word of the response
+// (see Terms.cpp).
+//
+// So a vector of sets of pairs of a string and a deque.  This is only a
+// simple program.
 //
 //----------------------------------------------------------------------------//
 
 namespace       Terms
 {
-    typedef pair< string, deque< string > >             CompoundTerm;
+    typedef pair< string, deque< string > >     CompoundTerm;
+
+    struct      MaskedTerm : public CompoundTerm
+    {
+        size_t  stem;       // the hash of the stem of the first word
+
+        MaskedTerm (const CompoundTerm& term, size_t stem) : CompoundTerm (term), stem (stem) {}
+    };
+
+    typedef vector< const MaskedTerm* >         MaskedTermSet;
 
-    typedef multimap< const string, deque< string> >    MaskedTermSet;
+    struct      MaskedTermList
+    {
+        MaskedTermSet       terms;      // of each set in turn
+        vector< size_t >    ends;       // of each set in terms
+
+        void    clear (void)    { terms.clear(); ends.clear(); }
+    };
+};
+
+//----------------------------------------------------------------------------//
+//
+// An AnswerKey is the source terms of a question compiled into the masked
+// terms they become when blanked:
+//    - a term is split at each "/" into alternatives (see Terms.cpp)
+//    - each alternative is split into its words, at spaces and hyphens,
+//      with the first letter of a simple term at the start of a sentence
+//      folded to lower case
+//    - the content mask of the term is built and interned
+//
+// The terms of a paragraph do not change once parsed so each term is compiled
+// once, the first time it is chosen to be blanked, and kept in the key for the
+// attempts that follow.  Terms::mask() then only chooses which terms to blank,
+// without allocating memory once the terms chosen have been compiled and the
+// masked term list has grown to size.  The masked term list points into the
+// key, which must outlive it.
+//
+//----------------------------------------------------------------------------//
 
-    typedef deque< MaskedTermSet >                      MaskedTermList;
+namespace       Terms
+{
+    class   AnswerKey;
+
+    extern  int     mask (MaskedTermList& maskedTerms, AnswerKey& answerKey, const int choices);
+
+    class   AnswerKey
+    {
+    public:
+        explicit AnswerKey (const SourceTermList& sourceTerms);
+
+    private:
+        AnswerKey (const AnswerKey&);               // not implemented
+        AnswerKey& operator= (const AnswerKey&);    // not implemented
+
+        friend  int     mask (MaskedTermList& maskedTerms, AnswerKey& answerKey, const int choices);
+
+    private:
+        struct  Term
+        {
+            Html::Element*  element;        // null when there is nothing to blank
+            const string*   contentMask;
+            size_t          first;          // of the alternatives of the term
+            size_t          last;
+            int             extra;          // choices counted for the "/" in the term
+            bool            compiled;
+        };
+
+        void    compile (Term& term);
+
+    private:
+        vector< Term >          terms;
+        deque< MaskedTerm >     alternatives;   // that do not move as more are added
+        vector< int >           order;          // in which to choose terms (for mask())
+    };
 };
 
 //----------------------------------------------------------------------------//
 //
 // There are three interface routines:
-//    - mask() generates the masked term list and sets content masks
+//    - mask() generates the masked term list from an answer key and sets
+//      content masks
 //    - check() checks the user's response against the mask term list
 //    - resets() the content masks
 //
@@ -101,6 +184,15 @@ namespace       Terms
 // Terms::mask() constructs a masked term list which is subsequently passed to
 // Terms::check() to compare against the user response.
 //
+// With Terms::typos set (by the --typo option), check() also accepts a word
+// within that many edits (letters inserted, deleted or changed) of the term
+// it answers, provided fewer than half the letters of the term are wrong.
+// A response with typos is not a correct one:  check() allows for typos only
+// when the caller passes typosFound to learn how many words had them.
+//
+// Terms::fuzzyCompare(), the heuristic word comparison used by check(), is
+// exposed so that it can be measured on its own by the benchmarks.
+//
 // For implementation details see Terms.cpp.
 //
 //----------------------------------------------------------------------------//
@@ -109,9 +201,13 @@ namespace   Terms
 {
     extern  void    reset (SourceTermList& sourceTerms);
 
-    extern  int     mask (MaskedTermList& maskedTerms, SourceTermList& sourceTerms, int termCount, const int choices);
+    extern  int     mask (MaskedTermList& maskedTerms, AnswerKey& answerKey, const int choices);
+
+    extern  bool    check (const MaskedTermList& maskedTerms, const string& response, int* typosFound = 0);
+
+    extern  bool    fuzzyCompare (const string& lhs, const string& rhs);
 
-    extern  bool    check (const MaskedTermList& maskedTerms, const string& response);
+    extern  int     typos;      // the edits allowed in a word (0 for none)
 };
 
 # endif  /* _TERMS_H */
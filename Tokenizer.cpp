@@ -0,0 +1,134 @@
+//----------------------------------------------------------------------------//
+//
+// Implementation file for the Html::Tokenizer class of the cribtutor program.
+//
+// The Tokenizer class reads the text, tags and comments of a cribsheet held
+// in memory.  See Tokenizer.h for a description of the class interface.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include "Tokenizer.h"
+
+#include <cctype>
+#include <cstring>
+
+using namespace std;
+
+//----------------------------------------------------------------------------//
+//
+// The tokenizer never looks at a character twice (the last character of the
+// tag that opens a comment excepted).
+//
+// The search for the '<' and '>' delimiters is left to memchr(), which the C
+// library implements with whatever vector instructions the machine has.  The
+// search for the "-->" that closes a comment is a search for '>' followed by a
+// check of the two characters before it.
+//
+// The behaviour at the end of the input is that of the original istream based
+// routines:  an unterminated tag is text and an unterminated comment runs to
+// the end of the input.
+//
+//----------------------------------------------------------------------------//
+
+//----  create a tokenizer positioned at the beginning of the text
+
+Html::Tokenizer::Tokenizer (const char* text, size_t length) :
+    cursor (text),
+    end (text + length),
+    tagStart (text)
+{
+}
+
+//----  read text upto the next html tag - append to any old content
+
+bool    Html::Tokenizer::readToNextTag (string& content)
+{
+    const char*     next = (const char *) memchr(cursor, '<', end - cursor);
+
+    if (next == 0)
+    {
+        content.append(cursor, end);
+        cursor = end;
+
+        return (false);
+    }
+
+    content.append(cursor, next);
+    cursor = next;
+
+    return (true);
+}
+
+//----  read an html tag
+
+bool    Html::Tokenizer::readTag (string& tag)
+{
+    const char*     next = (const char *) memchr(cursor, '>', end - cursor);
+
+    if (next == 0)
+    {
+        tag.assign(cursor, end);        // unexpected EOF
+        cursor = end;
+
+        return (false);
+    }
+
+    tagStart = cursor;
+
+    tag.assign(cursor, next + 1);
+    cursor = next + 1;
+
+    return (true);
+}
+
+//----  read the html comment opened by the tag just read and discard its tags
+
+bool    Html::Tokenizer::readComment (string& comment)
+{
+    const char*     begin = tagStart + 4;  // skip the <!--
+    const char*     next = begin;
+
+    while ((next = (const char *) memchr(next, '>', end - next)) != 0)
+    {
+        if (next - begin >= 2 && next[-1] == '-' && next[-2] == '-')
+        {
+            comment.assign(begin, next - 2);
+            cursor = next + 1;
+
+            return (true);
+        }
+
+        ++next;
+    }
+
+    comment.assign(begin, end);         // unexpected EOF
+    cursor = end;
+
+    return (false);
+}
+
+//----  discard new lines
+
+void    Html::Tokenizer::swallowNewLines (void)
+{
+    while (cursor != end && *cursor == '\n')
+        ++cursor;
+}
+
+//----  discard white space
+
+void    Html::Tokenizer::swallowSpace (void)
+{
+    while (cursor != end && isspace((unsigned char) *cursor))
+        ++cursor;
+}
+
+// EOF
@@ -0,0 +1,72 @@
+# ifndef    _TOKENIZER_H
+# define    _TOKENIZER_H
+
+//----------------------------------------------------------------------------//
+//
+// Interface file for the Html::Tokenizer class of the cribtutor program.
+//
+// The html parser reads a cribsheet as a sequence of text, tags and comments.
+// Originally it read them from an istream one character at a time.
+//
+// The Tokenizer class reads them from the cribsheet held in memory (usually a
+// mapping of the file).  It finds the '<' and '>' that bound tags with memchr()
+// and copies whole runs of text at once.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include <cstddef>
+#include <string>
+
+using namespace std;
+
+//----------------------------------------------------------------------------//
+//
+// A Tokenizer is a cursor over text that must outlive it.  The parser calls:
+//
+//      readToNextTag() - to append the text up to the next '<' to content
+//      readTag()       - to read the tag that starts at the '<'
+//      readComment()   - to read the comment opened by the tag just read
+//
+// Each returns false when it runs out of input.  Then readToNextTag() and
+// readTag() have appended what text there was to their parameter while
+// readComment() treats the end of the input as the end of the comment.
+//
+// swallowNewLines() and swallowSpace() discard white space from the input.
+//
+// atEnd() returns true once all the input has been read.
+//
+//----------------------------------------------------------------------------//
+
+namespace       Html
+{
+    class   Tokenizer
+    {
+    public:
+        Tokenizer (const char* text, size_t length);
+
+    public:
+        bool    readToNextTag (string& content);
+        bool    readTag (string& tag);
+        bool    readComment (string& comment);
+
+        void    swallowNewLines (void);
+        void    swallowSpace (void);
+
+        bool    atEnd (void) const  { return (cursor == end); }
+
+    private:
+        const char*     cursor;
+        const char*     end;
+        const char*     tagStart;
+    };
+};
+
+# endif  /* _TOKENIZER_H */
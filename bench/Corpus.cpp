@@ -0,0 +1,237 @@
+//----------------------------------------------------------------------------//
+//
+// Implementation file for the Corpus namespace of the cribtutor benchmarks.
+//
+// The Corpus namespace generates synthetic cribsheets.  The text is nonsense
+// but the markup is that of real cribsheets.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include "Corpus.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+
+//----------------------------------------------------------------------------//
+//
+// See Corpus.h for a description of the interface.
+//
+// Words are chosen by a private pseudo random number generator, not rand(),
+// so that generating a cribsheet does not disturb the quiz's shuffles.
+//
+// The terms include simple, compound, hyphenated and paired terms and words
+// with alternative spellings and plurals so that the masking and checking of
+// terms is exercised as it would be by a real cribsheet.  Code blocks include
+// character references.
+//
+//----------------------------------------------------------------------------//
+
+namespace       Corpus
+{
+    class   Random;
+
+    static  void    paragraph (const Shape& shape, Random& random, string& cribSheet);
+    static  void    list (Random& random, int depth, string& cribSheet);
+    static  void    codeBlock (Random& random, string& cribSheet);
+
+    static  const char*     pick (Random& random, const char* const words[], size_t count);
+    static  string  number (int value);
+
+    // the vocabulary
+
+    static  const char* const   fillers[] =
+    {
+        "the", "a", "program", "uses", "each", "when", "is", "of", "may", "be",
+        "with", "every", "so", "that", "an", "one", "which", "can", "not", "have"
+    };
+
+    static  const char* const   terms[] =
+    {
+        "template", "iterator", "compiler", "colour", "organisation", "analysis",
+        "analyses", "woman", "index", "indices", "specialisation", "container",
+        "virtual function", "copy-constructor", "input/output", "base class",
+        "allocator", "behaviour", "licence", "practise", "matrix", "vertex"
+    };
+
+    static  const char* const   joins[] = { " and ", " or ", "/" };
+
+    static  const size_t    fillerCount = sizeof(fillers) / sizeof(fillers[0]);
+    static  const size_t    termCount = sizeof(terms) / sizeof(terms[0]);
+    static  const size_t    joinCount = sizeof(joins) / sizeof(joins[0]);
+};
+
+//----  a small linear congruential generator
+
+class   Corpus::Random
+{
+public:
+    explicit Random (unsigned seed) : state (seed) {}
+
+    int     next (int range)
+    {
+        state = state * 1103515245 + 12345;
+
+        return ((state >> 16) % range);
+    }
+
+private:
+    unsigned    state;
+};
+
+//----  generate a cribsheet of the given shape
+
+string& Corpus::generate (const Shape& shape, string& cribSheet)
+{
+    Random  random (shape.seed);
+
+    cribSheet += "<h1> Generated Cribsheet </h1>\n\n";
+
+    for (int ii = 0; ii < shape.paragraphs; ++ii)
+    {
+        if (ii % 20 == 0)
+            cribSheet += "<h2> Chapter " + number(ii / 20 + 1) + " </h2>\n\n";
+
+        if (ii % 5 == 0)
+            cribSheet += "<h3> Section " + number(ii / 5 % 4 + 1) + " </h3>\n\n";
+
+        paragraph(shape, random, cribSheet);
+
+        if (random.next(100) < shape.codeDensity)
+            codeBlock(random, cribSheet);
+    }
+
+    return (cribSheet);
+}
+
+//----  set a member of the shape from a command line option
+
+bool    Corpus::setOption (Shape& shape, const string& option, const char* value)
+{
+    int*    member;
+
+    if (option == "-n" || option == "--paragraphs")
+        member = &shape.paragraphs;
+    else if (option == "-t" || option == "--terms")
+        member = &shape.terms;
+    else if (option == "-l" || option == "--lists")
+        member = &shape.listDensity;
+    else if (option == "-c" || option == "--code")
+        member = &shape.codeDensity;
+    else if (option == "-d" || option == "--depth")
+        member = &shape.depth;
+    else if (option == "-s" || option == "--seed")
+        member = &shape.seed;
+    else
+        return (false);
+
+    if (value)
+        *member = atoi(value);
+
+    return (true);
+}
+
+//----  a paragraph of sentences, one blankable term (or pair of terms) in each
+
+void    Corpus::paragraph (const Shape& shape, Random& random, string& cribSheet)
+{
+    cribSheet += "<p>\n";
+
+    for (int ii = 0; ii < shape.terms; ++ii)
+    {
+        cribSheet += ii == 0 ? "The" : "Then";
+
+        for (int jj = random.next(6); jj >= 0; --jj)
+            cribSheet += string(" ") + pick(random, fillers, fillerCount);
+
+        cribSheet += string(" <em>") + pick(random, terms, termCount) + "</em>";
+
+        if (random.next(4) == 0 && ii + 1 < shape.terms)
+        {
+            cribSheet += pick(random, joins, joinCount);
+            cribSheet += string("<em>") + pick(random, terms, termCount) + "</em>";
+
+            ++ii;
+        }
+
+        for (int jj = random.next(6); jj >= 0; --jj)
+            cribSheet += string(" ") + pick(random, fillers, fillerCount);
+
+        cribSheet += ".\n";
+    }
+
+    if (random.next(100) < shape.listDensity)
+    {
+        cribSheet += "There are several kinds:\n";
+
+        list(random, shape.depth, cribSheet);
+    }
+
+    cribSheet += "</p>\n\n";
+}
+
+//----  an unordered list of terms, with lists nested in the last item down to depth
+
+void    Corpus::list (Random& random, int depth, string& cribSheet)
+{
+    int     level = 1;
+
+    for (;; ++level)
+    {
+        cribSheet += "<ul>\n";
+
+        for (int ii = 0; ii < 2; ++ii)
+            cribSheet += string("<li><em>") + pick(random, terms, termCount) + "</em></li>\n";
+
+        cribSheet += string("<li><em>") + pick(random, terms, termCount) + "</em>";
+
+        if (level >= depth)
+            break;
+
+        cribSheet += "\n";
+    }
+
+    for (; level > 0; --level)
+        cribSheet += "</li>\n</ul>\n";
+}
+
+//----  a code block with character references
+
+void    Corpus::codeBlock (Random& random, string& cribSheet)
+{
+    cribSheet += "<pre><code>template &lt;typename T&gt;\n";
+
+    for (int ii = random.next(8); ii >= 0; --ii)
+        cribSheet += string("    ") + pick(random, terms, termCount) + " &amp;= " + number(ii) + ";\n";
+
+    cribSheet += "</code></pre>\n\n";
+}
+
+//----  pick a word at random
+
+const char*     Corpus::pick (Random& random, const char* const words[], size_t count)
+{
+    return (words[random.next(count)]);
+}
+
+//----  the text of a number
+
+string  Corpus::number (int value)
+{
+    char    buffer[16];
+
+    sprintf(buffer, "%d", value);
+
+    return (buffer);
+}
+
+// EOF
@@ -0,0 +1,81 @@
+# ifndef    _CORPUS_H
+# define    _CORPUS_H
+
+//----------------------------------------------------------------------------//
+//
+// Interface file for the Corpus namespace of the cribtutor benchmarks.
+//
+// The benchmarks need cribsheets of known size and shape:  a handful of real
+// cribsheets does not show how the program scales or which shapes of
+// cribsheet it handles badly.
+//
+// The Corpus namespace generates synthetic cribsheets.  The text is nonsense
+// but the markup is that of real cribsheets.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include <string>
+
+using namespace std;
+
+//----------------------------------------------------------------------------//
+//
+// The Shape structure describes the cribsheet to generate:
+//    - paragraphs - the number of paragraphs (questions)
+//    - terms - the number of blankable terms in each paragraph
+//    - listDensity - the percentage of paragraphs that contain a list
+//    - codeDensity - the percentage of paragraphs followed by a code block
+//    - depth - how deeply lists are nested
+//    - seed - the seed for the pseudo random choice of words
+//
+// Paragraphs are grouped five to a section and sections four to a chapter.
+//
+// Corpus::generate() appends the cribsheet to its parameter.  The same shape
+// always yields the same cribsheet.
+//
+// Corpus::setOption() sets a member of a shape from a command line option:
+//      -n | --paragraphs <n>
+//      -t | --terms <n>
+//      -l | --lists <percent>
+//      -c | --code <percent>
+//      -d | --depth <n>
+//      -s | --seed <n>
+// It returns false if the option is not one of these.
+//
+//----------------------------------------------------------------------------//
+
+namespace       Corpus
+{
+    struct      Shape
+    {
+        int         paragraphs;
+        int         terms;
+        int         listDensity;
+        int         codeDensity;
+        int         depth;
+        int         seed;
+
+        Shape () :
+            paragraphs (2000),
+            terms (4),
+            listDensity (20),
+            codeDensity (10),
+            depth (2),
+            seed (1)
+            {}
+    };
+
+    extern  string& generate (const Shape& shape, string& cribSheet);
+
+    extern  bool    setOption (Shape& shape, const string& option, const char* value);
+};
+
+# endif  /* _CORPUS_H */
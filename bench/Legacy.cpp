@@ -0,0 +1,124 @@
+//----------------------------------------------------------------------------//
+//
+// Implementation file for the Legacy namespace of the cribtutor benchmarks.
+//
+// The Legacy namespace keeps implementations that have been replaced so that
+// the benchmarks can compare them with their replacements.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include "Legacy.h"
+
+#include <algorithm>
+#include <string>
+
+using namespace std;
+
+//----  local routines
+
+namespace       Legacy
+{
+    static  void    adjustSpelling (string& lhs, string& rhs, const string& alt1, const string& alt2);
+};
+
+//---   heuristic string comparison to allow for alternative spellings and regular plurals
+
+bool    Legacy::fuzzyCompare (string lhs, string rhs)
+{
+    // adust terms for common alternative spellings
+
+    adjustSpelling (lhs, rhs, "isation", "ization");
+    adjustSpelling (lhs, rhs, "ise", "ize");
+    adjustSpelling (lhs, rhs, "ice", "ise");
+    adjustSpelling (lhs, rhs, "our", "or");
+
+    // ensure lhs is the shorter (singular) term
+
+    int     lhslen = lhs.length();
+    int     rhslen = rhs.length();
+
+    if (lhslen > rhslen)
+    {
+        swap(lhs, rhs);
+        swap(lhslen, rhslen);
+    }
+
+    // be prepared to tamper with the final character of the singular term
+
+    char&   lhsend = lhs[lhslen -1];
+
+    switch (rhslen - lhslen)
+    {
+        case (0):
+            // same length - either equal or irregluar plural like woman <-> women
+
+            if (lhs == rhs) return (true);
+
+            adjustSpelling (lhs, rhs, "man", "men");
+
+            if (lhs == rhs) return (true);
+
+            adjustSpelling (lhs, rhs, "sis", "ses");
+            adjustSpelling (lhs, rhs, "cis", "ces");
+            adjustSpelling (lhs, rhs, "xis", "xes");
+
+            if (lhs == rhs) return (true);
+
+            break;
+
+        case (1):
+            // one character shorter so possibly regular weak plural
+
+            if (lhs + "s" == rhs) return (true);
+
+            // perhaps latin e.g.  focus <-> foci
+
+            if (lhsend == 'i')
+                lhsend = 'u';
+
+            if (lhs + "s" == rhs) return (true);
+
+            break;
+
+        case (2):
+            // two characters shorter so something like potato <-> potatoes
+
+            if (lhs + "es" == rhs) return (true);
+
+            // perhaps half <-> halves or country <-> countries
+
+            if (lhsend == 'f')
+                lhsend = 'v';
+            else if (lhsend == 'y')
+                lhsend = 'i';
+
+            if (lhs + "es" == rhs) return (true);
+
+            break;
+    }
+
+    return (false);
+}
+
+//---   adjust spelling (e.g practice and practise so they may compare equal)
+
+void    Legacy::adjustSpelling (string& lhs, string& rhs, const string& alt1, const string& alt2)
+{
+    int     pos;
+
+    if ((pos = lhs.find(alt1)) != string::npos && rhs.rfind(alt2) == pos)
+        rhs.replace(pos, alt2.length(), alt1);
+
+    if ((pos = lhs.find(alt2)) != string::npos && rhs.rfind(alt1) == pos)
+        rhs.replace(pos, alt1.length(), alt2);
+}
+
+// EOF
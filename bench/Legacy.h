@@ -0,0 +1,39 @@
+# ifndef    _LEGACY_H
+# define    _LEGACY_H
+
+//----------------------------------------------------------------------------//
+//
+// Interface file for the Legacy namespace of the cribtutor benchmarks.
+//
+// The benchmarks time some routines against the implementations they
+// replaced so that the gain (or loss) can be seen on the same machine in the
+// same run.  The Legacy namespace keeps those implementations.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include <string>
+
+using namespace std;
+
+//----------------------------------------------------------------------------//
+//
+// Legacy::fuzzyCompare() is Terms::fuzzyCompare() as it was before the
+// spelling rules were held in a table (see Spellings.h):  the rules were
+// hard coded and applied by editing copies of the words.
+//
+//----------------------------------------------------------------------------//
+
+namespace       Legacy
+{
+    extern  bool    fuzzyCompare (string lhs, string rhs);
+};
+
+# endif  /* _LEGACY_H */
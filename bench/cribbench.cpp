@@ -0,0 +1,730 @@
+//----------------------------------------------------------------------------//
+//
+// The cribbench program measures the speed of the principal routines of the
+// cribtutor program.
+//
+// The only other test infrastructure is test/regress, which checks what the
+// program does but not how fast it does it.  cribbench times, one at a time:
+//
+//      Html::parseCribSheet()      - the parse, in a single pass
+//      printElement()              - via operator<< for Html::Element
+//      Terms::AnswerKey            - posing a question, with its first mask()
+//      Terms::mask()               - blanking terms for another attempt
+//      Html::Rendering::print()    - printing a question with its blanks
+//      Terms::check()              - checking a (correct) response
+//      Terms::check() (typos)      - checking a response with a typo per word
+//      Terms::fuzzyCompare()       - comparing words with alternative spellings
+//      Legacy::fuzzyCompare()      - the same, as it was before (see Legacy.h)
+//
+// on a synthetic cribsheet (see Corpus.h) or on a cribsheet file, and writes
+// the results to standard output as JSON so that runs can be compared:
+//
+//      cribbench -n 5000 -l 50 > after.json
+//      cribbench -f c++/templates.html -m 2
+//
+// Options:
+//      -f | --file <file> - time the cribsheet file instead of a synthetic one
+//      -m | --min-time <seconds> - the minimum time for each benchmark (0.5)
+//      and the options of Corpus::setOption() for the synthetic cribsheet
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include "Corpus.h"
+#include "Legacy.h"
+
+#include "Arena.h"
+#include "Html.h"
+#include "MappedFile.h"
+#include "Terms.h"
+
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <time.h>
+
+using namespace std;
+
+//----------------------------------------------------------------------------//
+//
+// Each benchmark repeats the operation it times until at least the minimum
+// time has passed.  Set up that the operation needs but that is not part of
+// it (parsing the tree to be printed, for example) is repeated too but is
+// not timed:  the Stopwatch is started and stopped around the operation only.
+//
+// An operation is one call of the routine timed except for Terms::AnswerKey,
+// Terms::mask(), Html::Rendering::print() and Terms::check(), which are called
+// for every paragraph in the cribsheet (Terms::check() with --typo 1 for the
+// typos), and Terms::fuzzyCompare() and Legacy::fuzzyCompare(), which are
+// called for every pair of words in a list.  The number of calls is reported
+// as the number of operations.
+//
+//----------------------------------------------------------------------------//
+
+namespace       Bench
+{
+    class   Stopwatch;
+
+    struct  Result
+    {
+        string  name;
+        long    operations;
+        double  seconds;
+        size_t  bytes;          // processed by each operation, if meaningful
+    };
+
+    typedef deque< Result >     ResultList;
+
+    // the answer keys of the questions of a cribsheet
+
+    class   AnswerKeys
+    {
+    public:
+        explicit AnswerKeys (const deque< Terms::SourceTermList >& questions);
+       ~AnswerKeys ();
+
+    public:
+        Terms::AnswerKey&   operator[] (size_t index)   { return (*keys[index]); }
+
+    private:
+        AnswerKeys (const AnswerKeys&);             // not implemented
+        AnswerKeys& operator= (const AnswerKeys&);  // not implemented
+
+    private:
+        deque< Terms::AnswerKey* >  keys;
+    };
+
+    // the benchmarks
+
+    static  Result  parse (const string& text);
+    static  Result  print (const string& text);
+    static  Result  compile (const string& text);
+    static  Result  mask (const string& text);
+    static  Result  render (const string& text);
+    static  Result  check (const string& text, const bool typos);
+    static  Result  fuzzyCompare (const bool legacy);
+
+    // helpers
+
+    static  void    buildTree (const string& text, Html::Element& html);
+    static  void    findQuestions (Html::Element& element, deque< Terms::SourceTermList >& questions, deque< Html::Element* >* paragraphs = 0);
+    static  void    findTermTags (Terms::SourceTermList& terms, Html::Element& element);
+    static  string  response (const Terms::MaskedTermList& maskedTerms, const bool typos = false);
+    static  string  typo (const string& word);
+
+    static  bool    enough (const Stopwatch& wall, long iterations);
+    static  void    report (ostream& stream, const string& source, const Corpus::Shape& shape, size_t bytes, const ResultList& results);
+    static  string  quote (const string& text);
+
+    // the minimum time for each benchmark
+
+    static  double  minimumTime = 0.5;
+};
+
+//----  accumulates the time between calls of start() and stop()
+
+class   Bench::Stopwatch
+{
+public:
+    Stopwatch () : total (0), began (0) {}
+
+    void    start (void)            { began = now(); }
+    void    stop (void)             { total += now() - began; }
+
+    double  seconds (void) const    { return (total); }
+    double  elapsed (void) const    { return (now() - began); }
+
+private:
+    static  double  now (void)
+    {
+        timespec    time;
+
+        clock_gettime(CLOCK_MONOTONIC, &time);
+
+        return (time.tv_sec + time.tv_nsec / 1e9);
+    }
+
+private:
+    double  total;
+    double  began;
+};
+
+//----  main
+
+int     main (int argc, char* argv[])
+{
+    Corpus::Shape   shape;
+
+    string  fileName;
+
+    for (int ii = 1; ii < argc; ++ii)
+    {
+        const string    arg = argv[ii];
+
+        if ((arg == "-f" || arg == "--file") && argv[ii + 1])
+            fileName = argv[++ii];
+        else if ((arg == "-m" || arg == "--min-time") && argv[ii + 1])
+            Bench::minimumTime = atof(argv[++ii]);
+        else if (Corpus::setOption(shape, arg, argv[ii + 1]))
+            ++ii;
+        else
+        {
+            cerr << "Not recognised: '" << arg << "'" << endl;
+            return (1);
+        }
+    }
+
+    string  text;
+
+    if (fileName.empty())
+    {
+        Corpus::generate(shape, text);
+    }
+    else
+    {
+        MappedFile  mapping (fileName);
+
+        if (!mapping.mapped())
+        {
+            cerr << "Not found: '" << fileName << "'" << endl;
+            return (1);
+        }
+
+        text.assign(mapping.data(), mapping.size());
+    }
+
+    Bench::ResultList   results;
+
+    results.push_back(Bench::parse(text));
+    results.push_back(Bench::print(text));
+    results.push_back(Bench::compile(text));
+    results.push_back(Bench::mask(text));
+    results.push_back(Bench::render(text));
+    results.push_back(Bench::check(text, false));
+    results.push_back(Bench::check(text, true));
+    results.push_back(Bench::fuzzyCompare(false));
+    results.push_back(Bench::fuzzyCompare(true));
+
+    Bench::report(cout, fileName.empty() ? "generated" : fileName, shape, text.length(), results);
+
+    return (0);
+}
+
+//----------------------------------------------------------------------------//
+//
+// The benchmarks.
+//
+//----------------------------------------------------------------------------//
+
+//----  time the parse
+
+Bench::Result   Bench::parse (const string& text)
+{
+    Result      result = { "parseCribSheet", 0, 0, text.length() };
+    Stopwatch   wall, timer;
+
+    for (wall.start(); !enough(wall, result.operations); ++result.operations)
+    {
+        Html::Arena         arena;
+        Html::Arena::Scope  scope (arena);
+        Html::Element       html;
+
+        timer.start();
+
+        Html::parseCribSheet(text.data(), text.length(), html);
+
+        timer.stop();
+    }
+
+    result.seconds = timer.seconds();
+
+    return (result);
+}
+
+//----  time printing the whole parse tree
+
+Bench::Result   Bench::print (const string& text)
+{
+    Result      result = { "printElement", 0, 0, text.length() };
+    Stopwatch   wall, timer;
+
+    Html::Arena         arena;
+    Html::Arena::Scope  scope (arena);
+    Html::Element       html;
+
+    buildTree(text, html);
+
+    for (wall.start(); !enough(wall, result.operations); ++result.operations)
+    {
+        ostringstream   stream;
+
+        timer.start();
+
+        stream << html;
+
+        timer.stop();
+    }
+
+    result.seconds = timer.seconds();
+
+    return (result);
+}
+
+//----  time blanking terms in every paragraph for the first time (with a new answer key)
+
+Bench::Result   Bench::compile (const string& text)
+{
+    Result      result = { "Terms::AnswerKey", 0, 0, 0 };
+    Stopwatch   wall, timer;
+
+    Html::Arena         arena;
+    Html::Arena::Scope  scope (arena);
+    Html::Element       html;
+
+    buildTree(text, html);
+
+    deque< Terms::SourceTermList >  questions;
+
+    findQuestions(html, questions);
+
+    wall.start();
+
+    for (long rounds = 0; !enough(wall, rounds); ++rounds)
+    {
+        result.operations += questions.size();
+
+        timer.start();
+
+        AnswerKeys  answerKeys (questions);
+
+        Terms::MaskedTermList   maskedTerms;
+
+        for (size_t ii = 0; ii < questions.size(); ++ii)
+            Terms::mask(maskedTerms, answerKeys[ii], 2);
+
+        timer.stop();
+
+        for (size_t ii = 0; ii < questions.size(); ++ii)
+            Terms::reset(questions[ii]);
+    }
+
+    result.seconds = timer.seconds();
+
+    return (result);
+}
+
+//----  time blanking terms in every paragraph again (with the same answer keys)
+
+Bench::Result   Bench::mask (const string& text)
+{
+    Result      result = { "Terms::mask", 0, 0, 0 };
+    Stopwatch   wall, timer;
+
+    Html::Arena         arena;
+    Html::Arena::Scope  scope (arena);
+    Html::Element       html;
+
+    buildTree(text, html);
+
+    deque< Terms::SourceTermList >  questions;
+
+    findQuestions(html, questions);
+
+    AnswerKeys  answerKeys (questions);
+
+    wall.start();
+
+    for (long rounds = 0; !enough(wall, rounds); ++rounds)
+    {
+        result.operations += questions.size();
+
+        Terms::MaskedTermList   maskedTerms;
+
+        timer.start();
+
+        for (size_t ii = 0; ii < questions.size(); ++ii)
+            Terms::mask(maskedTerms, answerKeys[ii], 2);
+
+        timer.stop();
+
+        for (size_t ii = 0; ii < questions.size(); ++ii)
+            Terms::reset(questions[ii]);
+    }
+
+    result.seconds = timer.seconds();
+
+    return (result);
+}
+
+//----  time printing every paragraph with blanks, rendered once
+
+Bench::Result   Bench::render (const string& text)
+{
+    Result      result = { "Rendering::print", 0, 0, 0 };
+    Stopwatch   wall, timer;
+
+    Html::Arena         arena;
+    Html::Arena::Scope  scope (arena);
+    Html::Element       html;
+
+    buildTree(text, html);
+
+    deque< Terms::SourceTermList >  questions;
+    deque< Html::Element* >         paragraphs;
+
+    findQuestions(html, questions, &paragraphs);
+
+    AnswerKeys  answerKeys (questions);
+
+    deque< Html::Rendering* >       renderings;
+
+    for (size_t ii = 0; ii < paragraphs.size(); ++ii)
+        renderings.push_back(new Html::Rendering (*paragraphs[ii]));
+
+    wall.start();
+
+    for (long rounds = 0; !enough(wall, rounds); ++rounds)
+    {
+        result.operations += questions.size();
+
+        Terms::MaskedTermList   maskedTerms;
+
+        for (size_t ii = 0; ii < questions.size(); ++ii)
+            Terms::mask(maskedTerms, answerKeys[ii], 2);
+
+        ostringstream   stream;
+
+        timer.start();
+
+        for (size_t ii = 0; ii < renderings.size(); ++ii)
+            stream << *renderings[ii];
+
+        timer.stop();
+
+        for (size_t ii = 0; ii < questions.size(); ++ii)
+            Terms::reset(questions[ii]);
+    }
+
+    for (size_t ii = 0; ii < renderings.size(); ++ii)
+        delete renderings[ii];
+
+    result.seconds = timer.seconds();
+
+    return (result);
+}
+
+//----  time checking a correct response, or one with typos, to a question on every paragraph
+
+Bench::Result   Bench::check (const string& text, const bool typos)
+{
+    Result      result = { typos ? "Terms::check (typos)" : "Terms::check", 0, 0, 0 };
+    Stopwatch   wall, timer;
+
+    Html::Arena         arena;
+    Html::Arena::Scope  scope (arena);
+    Html::Element       html;
+
+    buildTree(text, html);
+
+    deque< Terms::SourceTermList >  questions;
+
+    findQuestions(html, questions);
+
+    AnswerKeys  answerKeys (questions);
+
+    deque< Terms::MaskedTermList >  maskedTerms (questions.size());
+    deque< string >                 responses;
+
+    for (size_t ii = 0; ii < questions.size(); ++ii)
+    {
+        Terms::mask(maskedTerms[ii], answerKeys[ii], 2);
+        Terms::reset(questions[ii]);
+
+        responses.push_back(response(maskedTerms[ii], typos));
+    }
+
+    Terms::typos = typos ? 1 : 0;
+
+    int     typosFound = 0;
+
+    wall.start();
+
+    for (long rounds = 0; !enough(wall, rounds); ++rounds)
+    {
+        result.operations += questions.size();
+
+        timer.start();
+
+        for (size_t ii = 0; ii < questions.size(); ++ii)
+            Terms::check(maskedTerms[ii], responses[ii], &typosFound);
+
+        timer.stop();
+    }
+
+    Terms::typos = 0;
+
+    result.seconds = timer.seconds();
+
+    return (result);
+}
+
+//----  time comparing words with alternative spellings and plurals, by the rules or as before
+
+Bench::Result   Bench::fuzzyCompare (const bool legacy)
+{
+    static  const char*     pairs[][2] =
+    {
+        { "colour", "color" },          { "organisation", "organization" },
+        { "analysis", "analyses" },     { "woman", "women" },
+        { "index", "indices" },         { "template", "templates" },
+        { "matrix", "matrices" },       { "compiler", "iterator" },
+        { "licence", "license" },       { "behaviour", "behavior" },
+        { "class", "classes" },         { "vertex", "vertices" }
+    };
+
+    const size_t    pairCount = sizeof(pairs) / sizeof(pairs[0]);
+
+    Result      result = { legacy ? "Legacy::fuzzyCompare" : "Terms::fuzzyCompare", 0, 0, 0 };
+    Stopwatch   wall, timer;
+
+    deque< string >     words;
+
+    for (size_t ii = 0; ii < pairCount; ++ii)
+    {
+        words.push_back(pairs[ii][0]);
+        words.push_back(pairs[ii][1]);
+    }
+
+    wall.start();
+
+    for (long rounds = 0; !enough(wall, rounds); ++rounds)
+    {
+        result.operations += pairCount;
+
+        timer.start();
+
+        if (legacy)
+            for (size_t ii = 0; ii < words.size(); ii += 2)
+                Legacy::fuzzyCompare(words[ii], words[ii + 1]);
+        else
+            for (size_t ii = 0; ii < words.size(); ii += 2)
+                Terms::fuzzyCompare(words[ii], words[ii + 1]);
+
+        timer.stop();
+    }
+
+    result.seconds = timer.seconds();
+
+    return (result);
+}
+
+//----------------------------------------------------------------------------//
+//
+// Helpers.
+//
+//----------------------------------------------------------------------------//
+
+//----  parse a cribsheet
+
+void    Bench::buildTree (const string& text, Html::Element& html)
+{
+    Html::parseCribSheet(text.data(), text.length(), html);
+}
+
+//----  list the blankable terms of each paragraph that has any
+
+void    Bench::findQuestions (Html::Element& element, deque< Terms::SourceTermList >& questions, deque< Html::Element* >* paragraphs)
+{
+    typedef pair< Html::ElementContents::iterator, Html::ElementContents::iterator >    Range;
+
+    vector< Range >     stack (1, Range (element.contents.begin(), element.contents.end()));
+
+    while (!stack.empty())
+    {
+        Range&  range = stack.back();
+
+        if (range.first == range.second)
+        {
+            stack.pop_back();
+            continue;
+        }
+
+        Html::ElementContents::iterator     it = range.first++;
+
+        if (it->subElement == 0)
+            continue;
+
+        Html::Element&  subElement = *it->subElement;
+
+        if (subElement.tag != Html::Markup::para)
+        {
+            stack.push_back(Range (subElement.contents.begin(), subElement.contents.end()));
+            continue;
+        }
+
+        Terms::SourceTermList   terms;
+
+        findTermTags(terms, subElement);
+
+        if (terms.empty())
+            continue;
+
+        questions.push_back(terms);
+
+        if (paragraphs)
+            paragraphs->push_back(&subElement);
+    }
+}
+
+//----  list the blankable terms of an element (as Quiz::Process::findTermTags())
+
+void    Bench::findTermTags (Terms::SourceTermList& terms, Html::Element& element)
+{
+    typedef pair< Html::ElementContents::iterator, Html::ElementContents::iterator >    Range;
+
+    vector< Range >     stack (1, Range (element.contents.begin(), element.contents.end()));
+
+    while (!stack.empty())
+    {
+        Range&  range = stack.back();
+
+        if (range.first == range.second)
+        {
+            stack.pop_back();
+            continue;
+        }
+
+        Html::ElementContents::iterator     it = range.first++;
+
+        if (it->subElement == 0)
+            continue;
+
+        if (it->subElement->tag == Html::Markup::term)
+            terms.push_back(it);
+        else
+            stack.push_back(Range (it->subElement->contents.begin(), it->subElement->contents.end()));
+    }
+}
+
+//----  the correct response to a question
+
+string  Bench::response (const Terms::MaskedTermList& maskedTerms, const bool typos)
+{
+    string  text;
+
+    for (Terms::MaskedTermSet::const_iterator it = maskedTerms.terms.begin(); it != maskedTerms.terms.end(); ++it)
+    {
+        const Terms::CompoundTerm&  term = **it;
+
+        text += (typos ? typo(term.first) : term.first) + " ";
+
+        for (size_t ii = 0; ii < term.second.size(); ++ii)
+            text += (typos ? typo(term.second[ii]) : term.second[ii]) + " ";
+    }
+
+    return (text);
+}
+
+//----  a word with its middle letter left out, if it is long enough for --typo 1 to accept
+
+string  Bench::typo (const string& word)
+{
+    if (word.length() < 3)
+        return (word);
+
+    return (string (word).erase(word.length() / 2, 1));
+}
+
+//----  compile the answer key of each question
+
+Bench::AnswerKeys::AnswerKeys (const deque< Terms::SourceTermList >& questions)
+{
+    for (size_t ii = 0; ii < questions.size(); ++ii)
+        keys.push_back(new Terms::AnswerKey (questions[ii]));
+}
+
+Bench::AnswerKeys::~AnswerKeys ()
+{
+    for (size_t ii = 0; ii < keys.size(); ++ii)
+        delete keys[ii];
+}
+
+//----  has a benchmark run long enough ?
+
+bool    Bench::enough (const Stopwatch& wall, long iterations)
+{
+    return (iterations > 0 && wall.elapsed() >= minimumTime);
+}
+
+//----  write the results as JSON
+
+void    Bench::report (ostream& stream, const string& source, const Corpus::Shape& shape, size_t bytes, const ResultList& results)
+{
+    stream << "{" << endl;
+    stream << "  \"corpus\": {" << endl;
+    stream << "    \"source\": " << quote(source) << "," << endl;
+    stream << "    \"bytes\": " << bytes;
+
+    if (source == "generated")
+    {
+        stream << "," << endl;
+        stream << "    \"paragraphs\": " << shape.paragraphs << "," << endl;
+        stream << "    \"terms\": " << shape.terms << "," << endl;
+        stream << "    \"lists\": " << shape.listDensity << "," << endl;
+        stream << "    \"code\": " << shape.codeDensity << "," << endl;
+        stream << "    \"depth\": " << shape.depth << "," << endl;
+        stream << "    \"seed\": " << shape.seed;
+    }
+
+    stream << endl << "  }," << endl;
+    stream << "  \"results\": [" << endl;
+
+    for (ResultList::const_iterator it = results.begin(); it != results.end(); ++it)
+    {
+        const double    perOperation = it->operations ? it->seconds / it->operations : 0;
+
+        stream << "    { \"name\": " << quote(it->name);
+        stream << ", \"operations\": " << it->operations;
+        stream << ", \"seconds\": " << it->seconds;
+        stream << ", \"ns_per_op\": " << perOperation * 1e9;
+
+        if (it->bytes && perOperation > 0)
+            stream << ", \"mb_per_s\": " << it->bytes / perOperation / 1e6;
+
+        stream << " }" << (it + 1 != results.end() ? "," : "") << endl;
+    }
+
+    stream << "  ]" << endl;
+    stream << "}" << endl;
+}
+
+//----  quote a JSON string
+
+string  Bench::quote (const string& text)
+{
+    string  quoted ("\"");
+
+    for (size_t ii = 0; ii < text.length(); ++ii)
+    {
+        if (text[ii] == '"' || text[ii] == '\\')
+            quoted += '\\';
+
+        quoted += text[ii];
+    }
+
+    return (quoted + "\"");
+}
+
+// EOF
@@ -0,0 +1,54 @@
+//----------------------------------------------------------------------------//
+//
+// The gencrib program writes a synthetic cribsheet to standard output.
+//
+// The cribsheet is generated by the Corpus namespace (see Corpus.h) from the
+// shape given on the command line:
+//
+//      gencrib -n 5000 -t 6 -l 50 > big.html
+//
+// It is intended for trying the cribtutor program on cribsheets of a given
+// size and shape.  The cribtutor benchmarks generate their own.
+//
+//----------------------------------------------------------------------------//
+
+//----------------------------------------------------------------------------//
+//
+// https://github.com/NewForester/cribtutor
+// Copyright (C) 2016, 2017 NewForester
+// Released under the terms of the GNU GPL v2
+//
+//----------------------------------------------------------------------------//
+
+#include "Corpus.h"
+
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+//----  main
+
+int     main (int argc, char* argv[])
+{
+    Corpus::Shape   shape;
+
+    for (int ii = 1; ii < argc; ++ii)
+    {
+        if (!Corpus::setOption(shape, argv[ii], argv[ii + 1]))
+        {
+            cerr << "Not recognised: '" << argv[ii] << "'" << endl;
+            return (1);
+        }
+
+        ++ii;
+    }
+
+    string  cribSheet;
+
+    cout << Corpus::generate(shape, cribSheet);
+
+    return (0);
+}
+
+// EOF
@@ -14,7 +14,41 @@
 // processes cribsheets one at a time.  It opens the cribsheet but delegates
 // parsing to Html::parseCribSheet() and running the quiz to Quiz::run().
 //
-// See Html.h and Quiz.h for details.
+// Cribsheets whose names end in .md are Markdown, read by the Markdown reader
+// (see Markdown.h) rather than the html parser.
+//
+// Cribsheets are mapped into memory and parsed directly from the mapping.
+// Files that cannot be mapped (pipes, for example) are read through an
+// ifstream instead, as are all files when the --istream flag is given.
+//
+// With the --cache flag, the parse tree of a mapped cribsheet is saved to a
+// cache file and loaded from there by later runs until the cribsheet changes.
+//
+// A quiz does not wait for each cribsheet to be parsed after the previous
+// one is done with:  a background thread parses the next cribsheet or two
+// while the user answers questions on the current one.  With the --parallel
+// flag, the cribsheets to be processed are all parsed on a pool of threads,
+// one per processor.  Either way, they are processed in list order as their
+// parse trees become available.
+//
+// With the --stream flag, the quiz does not wait for the whole of a cribsheet
+// to be parsed either:  it starts on each chapter as soon as it is parsed.
+//
+// The parse tree of each cribsheet is allocated from an arena of its own and
+// released all at once when the cribsheet is done with.  With the --mem-stats
+// flag, the memory taken by each parse tree is reported on stderr.
+//
+// Responses are compared with the terms they answer allowing for alternative
+// spellings and plurals.  Rules for more may be given in spellings.txt, in
+// the same directory as the list of cribsheets.  With the --typo flag, words
+// with a typo or two are accepted too but reported as typos.
+//
+// With the --stats flag, the time taken by each phase of the run and counts of
+// the work done are reported on stderr when the program exits.  With the
+// --allocs flag, so are the allocations made by each subsystem.
+//
+// See Allocs.h, Arena.h, Cache.h, Footprint.h, Html.h, Loader.h, MappedFile.h,
+// Markdown.h, Quiz.h, Spellings.h, Stats.h and Terms.h for details.
 //
 //----------------------------------------------------------------------------//
 
@@ -26,9 +60,19 @@
 //
 //----------------------------------------------------------------------------//
 
+#include "Allocs.h"
+#include "Arena.h"
+#include "Cache.h"
+#include "Footprint.h"
 #include "Html.h"
+#include "Loader.h"
+#include "MappedFile.h"
+#include "Markdown.h"
 #include "Quiz.h"
 #include "SectionNumber.h"
+#include "Spellings.h"
+#include "Stats.h"
+#include "Terms.h"
 #include "cribtutor.h"
 
 #include <fstream>
@@ -37,6 +81,8 @@
 
 #include <cstdlib>
 
+#include <unistd.h>
+
 using namespace std;
 
 //----  program constants
@@ -49,14 +95,30 @@ const string    licence     = LICENCE;
 
 static  int     choices = 2;
 static  bool    runQuiz = true;
+static  bool    mapFiles = true;
+static  bool    useCache = false;
+static  bool    parallel = false;
+static  bool    memoryStats = false;
+static  bool    stream = false;
+
+static  const size_t    prefetch = 2;   // cribsheets parsed ahead of the quiz
 static  string  cribSheetDirectory (".");
 static  string  cribSheets ("cribsheets.txt");
+static  string  spellings ("spellings.txt");
 static  string  beginsWith;
 
 //----  forward declarations - first level routines
 
 static  void    cribSheetQuiz (const string& pathName, int choices);
 
+static  void    cribSheetQuizzes (const deque< string >& pathNames, int choices, int threads, size_t lookahead);
+
+static  void    streamCribSheet (const string& pathName, Loader& loader, size_t index, int choices);
+
+static  void    runCribSheet (const string& pathName, Html::Element& html, int choices);
+
+static  bool    readCribSheet (const string& pathName, Html::Element& html, Html::Chapters* chapters);
+
 static  void    processArguments (int argc, char* argv[]);
 
 //----  forward declarations - help routines
@@ -67,18 +129,38 @@ static  void    getCribsheetName (ifstream& sheets, string& pathName);
 
 static  string  file (const string& pathName);
 
+static  bool    isMarkdown (const string& pathName);
+
 static  string  directory (const string& pathName);
 
 static  string  normalise (const string& pathName);
 
+static  void    reportStats (void);
+
+static  void    reportAllocs (void);
+
 //----  main
 
 int     main (int argc, char* argv[])
 {
     processArguments (argc, argv);
 
+    // report at exit, after any loader has stopped (exit handlers run in reverse order)
+
+    if (Stats::enabled)
+        atexit(reportStats);
+
+    if (Allocs::enabled)
+        atexit(reportAllocs);
+
+    // add the spelling rules of the cribsheets, if there are any, to those built in
+
+    Terms::Spellings::load(cribSheetDirectory + spellings);
+
     // open the (external) list of cribsheets
 
+    Stats::Timer    listing (Stats::list);
+
     string      pathName (cribSheetDirectory + cribSheets);
 
     ifstream    sheets (pathName.c_str(), ios_base::in);
@@ -93,6 +175,8 @@ int     main (int argc, char* argv[])
 
     bool    fastForward = !beginsWith.empty();
 
+    deque< string >     pathNames;
+
     do
     {
         // get next cribsheet pathname
@@ -106,22 +190,34 @@ int     main (int argc, char* argv[])
         if (fastForward)
             fastForward = (file(pathName).compare(0, beginsWith.size(), beginsWith) != 0);
 
-        // process cribsheets one by one
+        // list the cribsheets to process
 
         if (!fastForward)
-            cribSheetQuiz(cribSheetDirectory + pathName, choices);
+            pathNames.push_back(cribSheetDirectory + pathName);
 
         if (!runQuiz && !fastForward)
             break;
     }
     while (sheets);
 
+    listing.stop();
+
     if (fastForward)
     {
         cerr << "Skip to: '" << beginsWith << "' not found" << endl;
         return (1);
     }
 
+    // process cribsheets one by one
+
+    if (parallel)
+        cribSheetQuizzes(pathNames, choices, sysconf(_SC_NPROCESSORS_ONLN), pathNames.size());
+    else if (runQuiz)
+        cribSheetQuizzes(pathNames, choices, 1, prefetch);
+    else
+        for (size_t ii = 0; ii < pathNames.size(); ++ii)
+            cribSheetQuiz(pathNames[ii], choices);
+
     return (0);
 }
 
@@ -135,21 +231,75 @@ int     main (int argc, char* argv[])
 
 void    cribSheetQuiz (const string& pathName, int choices)
 {
-    // open the cribsheet
+    // read and parse the cribsheet - the arena must outlive the parse tree
 
-    ifstream    cribSheet (pathName.c_str(), ios_base::in);
+    Html::Arena         arena;
+    Html::Arena::Scope  scope (arena);
+    Html::Element       html;
 
-    if (!cribSheet.good())
+    if (!readCribSheet(pathName, html, 0))
     {
          cerr << "Not found: '" << pathName << "'" << endl;
          return;
     }
 
-    // read and parse the cribsheet
+    runCribSheet(pathName, html, choices);
+}
 
-    Html::Element   html;
+//----  do cribsheet based quizzes, parsing the cribsheets in the background
+
+void    cribSheetQuizzes (const deque< string >& pathNames, int choices, int threads, size_t lookahead)
+{
+    const bool  streaming = stream && !memoryStats;     // the footprint is of the whole parse tree
+
+    Loader  loader (pathNames, readCribSheet, threads, lookahead, streaming);
+
+    for (size_t ii = 0; ii < pathNames.size(); ++ii)
+    {
+        if (streaming)
+        {
+            streamCribSheet(pathNames[ii], loader, ii, choices);
 
-    Html::parseCribSheet(cribSheet, html);
+            loader.release(ii);
+
+            continue;
+        }
+
+        Html::Element*  html = loader.wait(ii);
+
+        if (html == 0)
+        {
+            cerr << "Not found: '" << pathNames[ii] << "'" << endl;
+        }
+        else
+        {
+            Html::Arena::Scope  scope (loader.arena(ii));
+
+            runCribSheet(pathNames[ii], *html, choices);
+        }
+
+        loader.release(ii);
+    }
+}
+
+//----  run the quiz on a cribsheet, chapter by chapter as it is parsed
+
+void    streamCribSheet (const string& pathName, Loader& loader, size_t index, int choices)
+{
+    SectionNumber   prefix (pathName);
+
+    Stats::Timer    timer (Stats::render);
+
+    if (!Quiz::run(prefix, loader, index, choices))
+        cerr << "Not found: '" << pathName << "'" << endl;
+}
+
+//----  run the quiz on (or print) a parsed cribsheet
+
+void    runCribSheet (const string& pathName, Html::Element& html, int choices)
+{
+    if (memoryStats)
+        Footprint::report(cerr, pathName, html);
 
     if (runQuiz)
     {
@@ -157,16 +307,86 @@ void    cribSheetQuiz (const string& pathName, int choices)
 
         SectionNumber   prefix (pathName);
 
+        Stats::Timer    timer (Stats::render);
+
         Quiz::run (prefix, html, choices);
     }
     else
     {
         // just print the parsed html
 
+        Stats::Timer    timer (Stats::render);
+
         cout << html << endl;
     }
 }
 
+//----  open and parse a cribsheet - from a mapping if possible, otherwise from a stream
+
+bool    readCribSheet (const string& pathName, Html::Element& html, Html::Chapters* chapters)
+{
+    const bool  markdown = isMarkdown(pathName);
+
+    if (chapters)
+        chapters->tag = SectionNumber(pathName).singleDigit() ? Html::Markup::hdr1 : Html::Markup::hdr2;
+
+    if (mapFiles)
+    {
+        Stats::Timer    reading (Stats::read);
+
+        MappedFile  mapping (pathName);
+
+        reading.stop();
+
+        if (mapping.mapped())
+        {
+            if (useCache)
+            {
+                Stats::Timer    loading (Stats::cache);
+
+                if (Cache::load(pathName, mapping.data(), mapping.size(), html))
+                    return (true);
+            }
+
+            {
+                Stats::Timer    parsing (Stats::parse);
+
+                if (markdown)
+                    Html::Markdown::parseCribSheet(mapping.data(), mapping.size(), html, chapters);
+                else
+                    Html::parseCribSheet(mapping.data(), mapping.size(), html, chapters);
+            }
+
+            if (useCache && (chapters == 0 || chapters->element == 0))     // not once chapters are moved out
+            {
+                Stats::Timer    saving (Stats::cache);
+
+                Cache::save(pathName, mapping.data(), mapping.size(), html);
+            }
+
+            return (true);
+        }
+    }
+
+    Stats::Timer    reading (Stats::read);
+
+    ifstream    cribSheet (pathName.c_str(), ios_base::in);
+
+    reading.stop();
+
+    if (!cribSheet.good())
+        return (false);
+
+    Stats::Timer    parsing (Stats::parse);
+
+    if (markdown)
+        Html::Markdown::parseCribSheet(cribSheet, html, chapters);
+    else
+        Html::parseCribSheet(cribSheet, html, chapters);
+
+    return (true);
+}
+
 //----  process parameters (sets globals)
 
 void    processArguments (int argc, char* argv[])
@@ -236,6 +456,14 @@ void    processArguments (int argc, char* argv[])
             continue;
         }
 
+        if (arg == "-e" || arg == "--typo")
+        {
+            if (argv[++ii] != 0)
+                Terms::typos = convertInteger(argv[ii]);
+
+            continue;
+        }
+
         // test options
 
         if (arg == "-t" || arg == "--test")
@@ -261,6 +489,55 @@ void    processArguments (int argc, char* argv[])
             continue;
         }
 
+        if (arg == "-i" || arg == "--istream")
+        {
+            mapFiles = false;
+
+            continue;
+        }
+
+        if (arg == "-k" || arg == "--cache")
+        {
+            useCache = true;
+
+            continue;
+        }
+
+        if (arg == "-j" || arg == "--parallel")
+        {
+            parallel = true;
+
+            continue;
+        }
+
+        if (arg == "-m" || arg == "--mem-stats")
+        {
+            memoryStats = true;
+
+            continue;
+        }
+
+        if (arg == "-w" || arg == "--stream")
+        {
+            stream = true;
+
+            continue;
+        }
+
+        if (arg == "-x" || arg == "--stats")
+        {
+            Stats::enabled = true;
+
+            continue;
+        }
+
+        if (arg == "-a" || arg == "--allocs")
+        {
+            Allocs::enabled = true;
+
+            continue;
+        }
+
         // help options
 
         if (arg == "-h" || arg == "--help")
@@ -359,6 +636,15 @@ string  file (const string& pathName)
     return (pathName.substr(pos));
 }
 
+//----  is the cribsheet Markdown rather than html ?
+
+bool    isMarkdown (const string& pathName)
+{
+    const size_t    length = pathName.length();
+
+    return (length > 3 && pathName.compare(length - 3, 3, ".md") == 0);
+}
+
 //----  return the directory part of a path name
 
 string  directory (const string& pathName)
@@ -426,4 +712,18 @@ string  normalise (const string& pathName)
     return (normal);
 }
 
+//----  report the statistics of the run
+
+void    reportStats (void)
+{
+    Stats::report(cerr);
+}
+
+//----  report the allocations of the run
+
+void    reportAllocs (void)
+{
+    Allocs::report(cerr);
+}
+
 // EOF